@@ -0,0 +1,353 @@
+#include "corpus_generator.h"
+#include <random>
+
+namespace lexer {
+namespace bench {
+
+namespace {
+
+const char* const kOperators[] = {
+    "+", "-", "*", "/", "=", "<", ">", "!", "++", "--", "+=", "-=", "*=", "/=",
+    "==", "!=", "<=", ">=", "<<", ">>", "&&", "||", ";", ",", "(", ")", "{", "}"
+};
+
+const char* const kNames[] = {
+    "i", "j", "n", "sum", "arr", "count", "total", "result", "index", "value",
+    "buffer_size", "left", "right", "mid", "tmp", "node_count", "max_depth", "flag"
+};
+
+const char* const kIllegal[] = {
+    "@", "#", "$", "`", "~", "%", "^", "?", ":", "[", "]", ".", "\\", "'", "\"",
+    "&", "|", "\xE4\xB8\xAD", "\xC3\xA9"
+};
+
+const char* const kWords[] = {
+    "the", "lexer", "skips", "this", "text", "while", "scanning", "for", "the",
+    "closing", "marker", "of", "a", "block", "comment", "int", "x", "=", "1;"
+};
+
+// 只用 % 取值而不用标准分布，保证各平台生成的语料一致
+class Generator {
+public:
+    Generator(size_t targetBytes, std::uint32_t seed) : target_(targetBytes), rng_(seed) {
+        out_.reserve(targetBytes + 256);
+    }
+    
+    bool full() const {
+        return out_.size() >= target_;
+    }
+    
+    std::uint32_t pick(std::uint32_t n) {
+        return static_cast<std::uint32_t>(rng_() % n);
+    }
+    
+    template<size_t N>
+    const char* pick(const char* const (&items)[N]) {
+        return items[pick(static_cast<std::uint32_t>(N))];
+    }
+    
+    void identifier(size_t length) {
+        static const char first[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+        static const char rest[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+        out_ += first[pick(sizeof(first) - 1)];
+        for(size_t i = 1; i < length; ++i) {
+            out_ += rest[pick(sizeof(rest) - 1)];
+        }
+    }
+    
+    void number() {
+        out_ += std::to_string(pick(1000));
+    }
+    
+    void indent(int depth) {
+        out_.append(static_cast<size_t>(depth) * 4, ' ');
+    }
+    
+    void commentText(size_t length) {
+        size_t end = out_.size() + length;
+        while(out_.size() < end) {
+            out_ += pick(kWords);
+            out_ += ' ';
+        }
+    }
+    
+    std::string& out() {
+        return out_;
+    }
+    
+private:
+    size_t target_;
+    std::mt19937 rng_;
+    std::string out_;
+};
+
+void statement(Generator& g, int depth);
+
+void block(Generator& g, int depth) {
+    int count = 1 + static_cast<int>(g.pick(4));
+    for(int i = 0; i < count; ++i) {
+        statement(g, depth);
+    }
+}
+
+void condition(Generator& g) {
+    static const char* const comparisons[] = {" < ", " > ", " <= ", " >= ", " == ", " != "};
+    g.out() += g.pick(kNames);
+    g.out() += g.pick(comparisons);
+    g.number();
+    if(g.pick(4) == 0) {
+        g.out() += g.pick(2) ? " && " : " || ";
+        g.out() += g.pick(kNames);
+        g.out() += g.pick(comparisons);
+        if(g.pick(2)) {
+            g.number();
+        } else {
+            g.out() += g.pick(kNames);
+        }
+    }
+}
+
+void statement(Generator& g, int depth) {
+    std::string& out = g.out();
+    std::uint32_t choice = depth >= 4 ? 6 + g.pick(4) : g.pick(10);
+    g.indent(depth);
+    switch(choice) {
+    case 0:
+        out += "for (";
+        out += g.pick(kNames);
+        out += " = 0; ";
+        condition(g);
+        out += "; ";
+        out += g.pick(kNames);
+        out += "++) {\n";
+        block(g, depth + 1);
+        g.indent(depth);
+        out += "}\n";
+        break;
+    case 1:
+    case 2:
+        out += "if (";
+        condition(g);
+        out += ") {\n";
+        block(g, depth + 1);
+        g.indent(depth);
+        if(g.pick(3) == 0) {
+            out += "} else {\n";
+            block(g, depth + 1);
+            g.indent(depth);
+        }
+        out += "}\n";
+        break;
+    case 3:
+        out += "while (";
+        condition(g);
+        out += ") {\n";
+        block(g, depth + 1);
+        g.indent(depth);
+        out += "}\n";
+        break;
+    case 4:
+        out += "do {\n";
+        block(g, depth + 1);
+        g.indent(depth);
+        out += "} while (";
+        condition(g);
+        out += ");\n";
+        break;
+    case 5:
+        out += "/* ";
+        g.commentText(40);
+        out += "*/\n";
+        break;
+    case 6:
+        out += "int ";
+        out += g.pick(kNames);
+        out += " = ";
+        g.number();
+        out += ";\n";
+        break;
+    case 7: {
+        static const char* const assigns[] = {" = ", " += ", " -= ", " *= ", " /= "};
+        out += g.pick(kNames);
+        out += g.pick(assigns);
+        out += g.pick(kNames);
+        out += g.pick(2) ? " + " : " / ";
+        g.number();
+        out += ";\n";
+        break;
+    }
+    case 8:
+        out += g.pick(kNames);
+        out += g.pick(2) ? "++;\n" : "--;\n";
+        break;
+    default:
+        out += "// ";
+        g.commentText(30);
+        out += "\n";
+        break;
+    }
+}
+
+void realistic(Generator& g) {
+    while(!g.full()) {
+        std::string& out = g.out();
+        out += g.pick(3) ? "int " : "void ";
+        out += g.pick(kNames);
+        out += "_";
+        g.identifier(6);
+        out += "() {\n";
+        block(g, 1);
+        out += "    return ";
+        out += g.pick(kNames);
+        out += ";\n}\n\n";
+    }
+}
+
+void operatorSoup(Generator& g) {
+    std::string& out = g.out();
+    size_t lineStart = 0;
+    while(!g.full()) {
+        const char* op = g.pick(kOperators);
+        // '/'后紧跟'/'或'*'会变成注释，插入空格隔开
+        if(!out.empty() && out.back() == '/' && (op[0] == '/' || op[0] == '*')) {
+            out += ' ';
+        }
+        out += op;
+        if(g.pick(8) == 0) {
+            out += ' ';
+        }
+        if(out.size() - lineStart > 80) {
+            out += '\n';
+            lineStart = out.size();
+        }
+    }
+    out += '\n';
+}
+
+void longComments(Generator& g) {
+    std::string& out = g.out();
+    while(!g.full()) {
+        if(g.pick(4) == 0) {
+            out += "// ";
+            g.commentText(60 + g.pick(40));
+            out += "\n";
+        } else {
+            out += "/*\n";
+            int lines = 5 + static_cast<int>(g.pick(40));
+            for(int i = 0; i < lines; ++i) {
+                out += " * ";
+                g.commentText(60 + g.pick(40));
+                out += "\n";
+            }
+            out += " */\n";
+        }
+        out += "int ";
+        out += g.pick(kNames);
+        out += " = 0;\n";
+    }
+}
+
+void unterminated(Generator& g) {
+    std::string& out = g.out();
+    out += "int main() {\n";
+    block(g, 1);
+    out += "/* 这个注释直到文件末尾都没有闭合\n";
+    while(!g.full()) {
+        out += " * ";
+        g.commentText(60 + g.pick(40));
+        out += "\n";
+    }
+}
+
+void identifiers(Generator& g) {
+    std::string& out = g.out();
+    std::vector<size_t> starts;
+    std::vector<size_t> lengths;
+    while(!g.full()) {
+        out += "int ";
+        for(int i = 0; i < 2; ++i) {
+            // 一半复用已出现的名字，使符号表同时经受插入和命中
+            if(!starts.empty() && g.pick(2) == 0) {
+                size_t k = g.pick(static_cast<std::uint32_t>(starts.size()));
+                out.append(out, starts[k], lengths[k]);
+            } else {
+                std::uint32_t roll = g.pick(10);
+                size_t length = roll < 5 ? 32 : roll < 8 ? 33 + g.pick(32) : 1 + g.pick(12);
+                starts.push_back(out.size());
+                lengths.push_back(length);
+                g.identifier(length);
+            }
+            out += i == 0 ? " = " : ";\n";
+        }
+    }
+}
+
+void illegalFlood(Generator& g) {
+    std::string& out = g.out();
+    size_t lineStart = 0;
+    while(!g.full()) {
+        if(g.pick(4) == 0) {
+            g.identifier(1 + g.pick(8));
+            out += ' ';
+        } else {
+            out += g.pick(kIllegal);
+        }
+        if(out.size() - lineStart > 80) {
+            out += '\n';
+            lineStart = out.size();
+        }
+    }
+    out += '\n';
+}
+
+}
+
+const std::vector<CorpusInfo>& corpusKinds() {
+    static const std::vector<CorpusInfo> kinds = {
+        {CorpusKind::REALISTIC, "realistic", "嵌套控制流的常规代码"},
+        {CorpusKind::OPERATOR_SOUP, "operators", "密集运算符"},
+        {CorpusKind::LONG_COMMENTS, "comments", "大段注释"},
+        {CorpusKind::UNTERMINATED, "unterminated", "未闭合的多行注释"},
+        {CorpusKind::IDENTIFIERS, "identifiers", "32字符与超长标识符"},
+        {CorpusKind::ILLEGAL_FLOOD, "illegal", "大量非法字符"},
+    };
+    return kinds;
+}
+
+bool parseCorpusKind(std::string_view name, CorpusKind& kind) {
+    for(const auto& info : corpusKinds()) {
+        if(name == info.name) {
+            kind = info.kind;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string generateCorpus(CorpusKind kind, size_t targetBytes, std::uint32_t seed) {
+    Generator g(targetBytes, seed);
+    switch(kind) {
+    case CorpusKind::REALISTIC:
+        realistic(g);
+        break;
+    case CorpusKind::OPERATOR_SOUP:
+        operatorSoup(g);
+        break;
+    case CorpusKind::LONG_COMMENTS:
+        longComments(g);
+        break;
+    case CorpusKind::UNTERMINATED:
+        unterminated(g);
+        break;
+    case CorpusKind::IDENTIFIERS:
+        identifiers(g);
+        break;
+    case CorpusKind::ILLEGAL_FLOOD:
+        illegalFlood(g);
+        break;
+    }
+    return std::move(g.out());
+}
+
+}
+}
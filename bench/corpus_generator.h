@@ -0,0 +1,36 @@
+#ifndef CORPUS_GENERATOR_H
+#define CORPUS_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lexer {
+namespace bench {
+
+enum class CorpusKind {
+    REALISTIC,          // 形如examples/test_case_8_complex_nested.c的嵌套控制流代码
+    OPERATOR_SOUP,      // 密集的运算符和分界符
+    LONG_COMMENTS,      // 大段多行注释和单行注释
+    UNTERMINATED,       // 开头不远处打开、直到文件末尾都未闭合的多行注释
+    IDENTIFIERS,        // 恰好32个字符和超长的标识符
+    ILLEGAL_FLOOD       // 大量非法字符
+};
+
+struct CorpusInfo {
+    CorpusKind kind;
+    const char* name;
+    const char* description;
+};
+
+const std::vector<CorpusInfo>& corpusKinds();
+bool parseCorpusKind(std::string_view name, CorpusKind& kind);
+
+// 生成约targetBytes字节的语料；相同的参数总是得到相同的内容
+std::string generateCorpus(CorpusKind kind, size_t targetBytes, std::uint32_t seed);
+
+}
+}
+
+#endif
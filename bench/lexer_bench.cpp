@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "corpus_generator.h"
+#include "lexer.h"
+#include "lexer_capi.h"
+#include "simd_scan.h"
+#include "symbol_table.h"
+
+namespace fs = std::filesystem;
+using namespace lexer;
+using namespace lexer::bench;
+
+// small_files_*基准每个片段的目标大小
+constexpr size_t kPieceSize = 4096;
+
+struct BenchOptions {
+    size_t sizeMiB = 16;
+    size_t iterations = 5;
+    std::uint32_t seed = 1;
+    std::vector<CorpusKind> corpora;
+    std::string jsonFile;               // 为空时不输出JSON，"-"为标准输出
+    std::string corpusDir;              // 非空时只把语料写入该目录
+    std::string outputDir;              // write*基准的输出目录
+    bool showHelp = false;
+    bool invalid = false;               // 参数有误：显示帮助后以非0状态退出
+};
+
+// 一项基准的结果：bytes/items是一次运行处理的字节数和条目数（Token或标识符），
+// 吞吐量按各次运行时间的中位数计算
+struct BenchResult {
+    std::string corpus;
+    std::string benchmark;
+    size_t bytes = 0;
+    size_t items = 0;
+    size_t outputBytes = 0;
+    double medianSeconds = 0;
+    double minSeconds = 0;
+};
+
+void showHelp(const char* programName) {
+    std::cout << "用法: " << programName << " [选项]\n\n";
+    std::cout << "选项:\n";
+    std::cout << "  --size <MiB>             每种语料的大小（默认: 16）\n";
+    std::cout << "  --iterations <n>         每项基准的运行次数，取中位数（默认: 5）\n";
+    std::cout << "  --seed <n>               语料生成的随机种子（默认: 1）\n";
+    std::cout << "  --corpus <a,b,...>       只运行指定语料（默认: 全部）\n";
+    std::cout << "  --json <file>            结果同时写成JSON，\"-\"表示标准输出\n";
+    std::cout << "  --output-dir <dir>       write*基准的输出目录（默认: 系统临时目录）\n";
+    std::cout << "  --write-corpus <dir>     只生成语料文件到目录后退出\n";
+    std::cout << "  -h, --help               显示此帮助信息\n\n";
+    std::cout << "语料:\n";
+    for(const auto& info : corpusKinds()) {
+        std::cout << "  " << std::left << std::setw(25) << info.name << info.description << "\n";
+    }
+}
+
+// 与main.cpp相同：解析完整的非负十进制整数；为空、含其他字符或超出Integer的范围时返回false
+template <typename Integer>
+bool parseCount(const char* text, Integer& value) {
+    const char* end = text + std::strlen(text);
+    auto parsed = std::from_chars(text, end, value);
+    return text != end && parsed.ec == std::errc() && parsed.ptr == end;
+}
+
+BenchOptions parseArguments(int argc, char* argv[]) {
+    BenchOptions options;
+    for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "-h" || arg == "--help") {
+            options.showHelp = true;
+            return options;
+        } else if(arg == "--size" || arg == "--iterations" || arg == "--seed") {
+            const char* value = hasValue ? argv[++i] : "";
+            bool parsed;
+            if(arg == "--size") {
+                // 换算成字节后不能溢出
+                parsed = parseCount(value, options.sizeMiB) && options.sizeMiB <= (SIZE_MAX >> 20);
+            } else if(arg == "--iterations") {
+                parsed = parseCount(value, options.iterations);
+                options.iterations = std::max<size_t>(1, options.iterations);
+            } else {
+                parsed = parseCount(value, options.seed);
+            }
+            if(!parsed) {
+                std::cerr << "错误: " << arg << " 需要一个非负整数参数\n";
+                options.showHelp = true;
+                options.invalid = true;
+                return options;
+            }
+        } else if(arg == "--corpus" && hasValue) {
+            std::stringstream names(argv[++i]);
+            for(std::string name; std::getline(names, name, ',');) {
+                CorpusKind kind;
+                if(!parseCorpusKind(name, kind)) {
+                    std::cerr << "错误: 未知语料 '" << name << "'\n";
+                    options.showHelp = true;
+                    options.invalid = true;
+                    return options;
+                }
+                options.corpora.push_back(kind);
+            }
+        } else if(arg == "--json" && hasValue) {
+            options.jsonFile = argv[++i];
+        } else if(arg == "--output-dir" && hasValue) {
+            options.outputDir = argv[++i];
+        } else if(arg == "--write-corpus" && hasValue) {
+            options.corpusDir = argv[++i];
+        } else {
+            std::cerr << "错误: 未知选项或缺少参数 '" << arg << "'\n";
+            options.showHelp = true;
+            options.invalid = true;
+            return options;
+        }
+    }
+    if(options.corpora.empty()) {
+        for(const auto& info : corpusKinds()) {
+            options.corpora.push_back(info.kind);
+        }
+    }
+    return options;
+}
+
+const char* corpusName(CorpusKind kind) {
+    for(const auto& info : corpusKinds()) {
+        if(info.kind == kind) {
+            return info.name;
+        }
+    }
+    return "";
+}
+
+// setup不计时，run计时；返回各次运行时间的中位数和最小值
+void measure(BenchResult& result, size_t iterations, const std::function<void()>& setup,
+             const std::function<void()>& run) {
+    std::vector<double> seconds;
+    for(size_t i = 0; i < iterations; ++i) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(seconds.begin(), seconds.end());
+    result.medianSeconds = seconds[seconds.size() / 2];
+    result.minSeconds = seconds.front();
+}
+
+void benchCorpus(CorpusKind kind, const std::string& source, const BenchOptions& options,
+                 std::vector<BenchResult>& results) {
+    const std::string corpus = corpusName(kind);
+    auto make = [&](const char* benchmark, size_t bytes, size_t items) {
+        BenchResult result;
+        result.corpus = corpus;
+        result.benchmark = benchmark;
+        result.bytes = bytes;
+        result.items = items;
+        return result;
+    };
+    
+    // tokenize()：每次都从新的Lexer开始
+    std::unique_ptr<Lexer> lex;
+    BenchResult tokenize = make("tokenize", source.size(), 0);
+    measure(tokenize, options.iterations,
+            [&] { lex = std::make_unique<Lexer>(std::string_view(source)); },
+            [&] { lex->tokenize(); });
+    tokenize.items = lex->getTokens().size();
+    results.push_back(tokenize);
+    
+    // 只记偏移、不维护行号的扫描
+    using OffsetsLexer = BasicLexer<kAllFeatures & ~kTrackPositions>;
+    std::unique_ptr<OffsetsLexer> offsetsLex;
+    BenchResult offsets = make("tokenize_offsets", source.size(), tokenize.items);
+    measure(offsets, options.iterations,
+            [&] { offsetsLex = std::make_unique<OffsetsLexer>(std::string_view(source)); },
+            [&] { offsetsLex->tokenize(); });
+    offsetsLex.reset();
+    results.push_back(offsets);
+    
+    // 功能最少的实例：只按类别计数，不物化Token、不登记符号、不记录错误
+    using CountingLexer = BasicLexer<0>;
+    std::unique_ptr<CountingLexer> countingLex;
+    BenchResult counting = make("tokenize_count", source.size(), tokenize.items);
+    measure(counting, options.iterations,
+            [&] { countingLex = std::make_unique<CountingLexer>(std::string_view(source)); },
+            [&] { countingLex->tokenize(); });
+    countingLex.reset();
+    results.push_back(counting);
+    
+    // UTF-8校验：纯ASCII的块整块跳过
+    size_t validPrefix = 0;
+    BenchResult validate = make("utf8_validate", source.size(), 0);
+    measure(validate, options.iterations, [] {}, [&] {
+        const char* data = source.data();
+        validPrefix = static_cast<size_t>(simd::findInvalidUtf8(data, data + source.size()) - data);
+    });
+    validate.items = validPrefix;
+    results.push_back(validate);
+    
+    // 大量小文件：按换行切成约4KiB的片段，比较每片新建Lexer与复用同一个Lexer
+    std::vector<std::string_view> pieces;
+    for(size_t begin = 0; begin < source.size();) {
+        size_t end = source.find('\n', std::min(begin + kPieceSize, source.size()));
+        end = end == std::string::npos ? source.size() : end + 1;
+        pieces.push_back(std::string_view(source).substr(begin, end - begin));
+        begin = end;
+    }
+    BenchResult fresh = make("small_files_fresh", source.size(), pieces.size());
+    measure(fresh, options.iterations, [] {}, [&] {
+        for(auto piece : pieces) {
+            Lexer pieceLex(piece);
+            pieceLex.tokenize();
+        }
+    });
+    results.push_back(fresh);
+    Lexer reused{std::string_view()};
+    BenchResult reset = make("small_files_reset", source.size(), pieces.size());
+    measure(reset, options.iterations, [] {}, [&] {
+        for(auto piece : pieces) {
+            reused.reset(piece);
+            reused.tokenize();
+        }
+    });
+    results.push_back(reset);
+    
+    // C接口：复用同一个会话，每批4096个Token填入调用方的数组
+    lexer_session* session = lexer_create(LEXER_ALL_FEATURES);
+    std::vector<lexer_token> batch(4096);
+    size_t capiTokens = 0;
+    BenchResult capi = make("capi_batch", source.size(), tokenize.items);
+    measure(capi, options.iterations, [&] { capiTokens = 0; }, [&] {
+        lexer_reset(session, source.data(), source.size());
+        size_t count = 0;
+        while(lexer_next_tokens(session, batch.data(), batch.size(), &count) == LEXER_OK && count > 0) {
+            capiTokens += count;
+        }
+    });
+    lexer_destroy(session);
+    results.push_back(capi);
+    if(capiTokens != tokenize.items) {
+        std::cerr << "警告: " << corpus << " 的C接口Token数与tokenize()不一致\n";
+    }
+    
+    // SymbolTable：插入与查询全部标识符Token（含重复），字节数为标识符总长
+    std::vector<std::string_view> names;
+    size_t nameBytes = 0;
+    for(const auto& token : lex->getTokens()) {
+        if(token.getType() == TokenType::IDENTIFIER) {
+            names.push_back(token.getValue(source));
+            nameBytes += names.back().size();
+        }
+    }
+    std::unique_ptr<SymbolTable> table;
+    BenchResult insert = make("symbol_insert", nameBytes, names.size());
+    measure(insert, options.iterations,
+            [&] { table = std::make_unique<SymbolTable>(); },
+            [&] {
+                for(auto name : names) {
+                    table->insert(name);
+                }
+            });
+    results.push_back(insert);
+    
+    BenchResult lookup = make("symbol_lookup", nameBytes, names.size());
+    size_t found = 0;
+    measure(lookup, options.iterations, [] {}, [&] {
+        for(auto name : names) {
+            found += table->lookup(name) != nullptr;
+        }
+    });
+    results.push_back(lookup);
+    if(found != names.size() * options.iterations) {
+        std::cerr << "警告: " << corpus << " 的符号查询结果不完整\n";
+    }
+    
+    // write*：写入真实文件，按源码字节数和Token数计吞吐量。write_token_refs以符号id写出标识符
+    struct Writer {
+        const char* name;
+        void (*write)(const Lexer&, const std::string&);
+    };
+    const Writer writers[] = {
+        {"write_tokens", [](const Lexer& lexer, const std::string& path) { lexer.writeTokens(path); }},
+        {"write_token_refs", [](const Lexer& lexer, const std::string& path) { lexer.writeTokens(path, true); }},
+        {"write_symbol_table", [](const Lexer& lexer, const std::string& path) { lexer.writeSymbolTable(path); }},
+        {"write_errors", [](const Lexer& lexer, const std::string& path) { lexer.writeErrors(path); }},
+    };
+    for(const auto& writer : writers) {
+        std::string path = (fs::path(options.outputDir) / (corpus + "_" + writer.name + ".txt")).string();
+        BenchResult result = make(writer.name, source.size(), tokenize.items);
+        measure(result, options.iterations, [] {}, [&] { writer.write(*lex, path); });
+        result.outputBytes = static_cast<size_t>(fs::file_size(path));
+        fs::remove(path);
+        results.push_back(result);
+    }
+}
+
+double perSecond(double amount, double seconds) {
+    return seconds > 0 ? amount / seconds : 0;
+}
+
+void printTable(const std::vector<BenchResult>& results) {
+    // setw按字节计宽，每个汉字占3字节、显示2列，表头多留相应宽度
+    std::cout << std::left << std::setw(16) << "语料" << std::setw(22) << "基准"
+              << std::right << std::setw(12) << "MB/s" << std::setw(16) << "items/s"
+              << std::setw(17) << "中位数(ms)" << "\n";
+    std::cout << std::fixed;
+    for(const auto& result : results) {
+        std::cout << std::left << std::setw(14) << result.corpus << std::setw(20) << result.benchmark
+                  << std::right << std::setprecision(1)
+                  << std::setw(12) << perSecond(result.bytes / 1e6, result.medianSeconds)
+                  << std::setprecision(0)
+                  << std::setw(16) << perSecond(static_cast<double>(result.items), result.medianSeconds)
+                  << std::setprecision(2)
+                  << std::setw(14) << result.medianSeconds * 1e3 << "\n";
+    }
+}
+
+void writeJson(std::ostream& out, const std::vector<BenchResult>& results, const BenchOptions& options) {
+    out << std::setprecision(6) << std::fixed;
+    out << "{\n  \"schema\": 1,\n";
+    out << "  \"corpus_bytes\": " << (options.sizeMiB << 20) << ",\n";
+    out << "  \"iterations\": " << options.iterations << ",\n";
+    out << "  \"seed\": " << options.seed << ",\n";
+    out << "  \"results\": [\n";
+    for(size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "    {\"corpus\": \"" << r.corpus << "\", \"benchmark\": \"" << r.benchmark
+            << "\", \"bytes\": " << r.bytes << ", \"items\": " << r.items
+            << ", \"output_bytes\": " << r.outputBytes
+            << ", \"median_seconds\": " << r.medianSeconds << ", \"min_seconds\": " << r.minSeconds
+            << ", \"mb_per_s\": " << perSecond(r.bytes / 1e6, r.medianSeconds)
+            << ", \"items_per_s\": " << perSecond(static_cast<double>(r.items), r.medianSeconds)
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options = parseArguments(argc, argv);
+    if(options.showHelp) {
+        showHelp(argv[0]);
+        return options.invalid ? 1 : 0;
+    }
+    
+    size_t targetBytes = options.sizeMiB << 20;
+    if(!options.corpusDir.empty()) {
+        fs::create_directories(options.corpusDir);
+        for(CorpusKind kind : options.corpora) {
+            std::string path = (fs::path(options.corpusDir) / (std::string(corpusName(kind)) + ".c")).string();
+            std::ofstream(path, std::ios::binary) << generateCorpus(kind, targetBytes, options.seed);
+            std::cout << "已生成: " << path << "\n";
+        }
+        return 0;
+    }
+    
+    if(options.outputDir.empty()) {
+        options.outputDir = fs::temp_directory_path().string();
+    }
+    fs::create_directories(options.outputDir);
+    
+    std::vector<BenchResult> results;
+    for(CorpusKind kind : options.corpora) {
+        std::string source = generateCorpus(kind, targetBytes, options.seed);
+        benchCorpus(kind, source, options, results);
+    }
+    
+    if(options.jsonFile == "-") {
+        writeJson(std::cout, results, options);
+        return 0;
+    }
+    printTable(results);
+    if(!options.jsonFile.empty()) {
+        std::ofstream json(options.jsonFile);
+        writeJson(json, results, options);
+        if(!json) {
+            std::cerr << "错误: 无法写入 " << options.jsonFile << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -1,33 +1,100 @@
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "src/batch_runner.h"
+#include "src/lex_pipeline.h"
 #include "src/lexer.h"
+#include "src/lexer_server.h"
+#include "src/lexer_stats.h"
+#include "src/output_writer.h"
+#include "src/parallel_lexer.h"
+#include "src/result_cache.h"
+#include "src/source_file.h"
+#include "src/stream_lexer.h"
+#include "src/token_stream.h"
 
 namespace fs = std::filesystem;
 
 struct Options {
     std::string inputFile;
+    std::vector<std::string> inputs;    // 批处理模式下的全部输入（文件、目录或"-"）
+    bool batch = false;
+    bool stream = false;                // 以有界内存分段读入单个输入
+    bool pipeline = false;              // 流式输入时读、分析、写分在三个线程
     std::string outputDir = "output";
     std::string tokensFile = "tokens.txt";
     std::string symbolsFile = "symbol_table.txt";
     std::string errorsFile = "errors.txt";
+    std::string binaryFile;             // 为空时不输出二进制Token流
+    size_t threads = 1;
+    std::string serve;                  // 守护进程模式的套接字路径，"-"表示标准输入输出
+    std::string cacheDir;               // 为空时不使用结果缓存
+    std::uint64_t cacheLimitMiB = 1024;
+    std::string statsFile;              // 为空时不输出运行统计
+    size_t maxErrors = 0;               // 每个文件最多记录的错误数，0表示不限
+    unsigned outputs = lexer::kAllOutputs;  // 要写出的文本结果（OutputKind的组合）
+    bool symbolRefs = false;            // Token结果中的标识符写作符号id
     bool showHelp = false;
 };
 
 void showHelp(const char* programName) {
-    std::cout << "用法: " << programName << " <input_file> [选项]\n\n";
+    std::cout << "用法: " << programName << " <input_file> [选项]\n";
+    std::cout << "      " << programName << " <文件|目录|-> ... [选项]    批处理模式\n\n";
     std::cout << "选项:\n";
     std::cout << "  -o, --output-dir <dir>    输出目录（默认: output）\n";
     std::cout << "  --tokens <file>           Token文件名（默认: tokens.txt）\n";
     std::cout << "  --symbols <file>          符号表文件名（默认: symbol_table.txt）\n";
     std::cout << "  --errors <file>           错误文件名（默认: errors.txt）\n";
+    std::cout << "  --binary <file>           同时输出二进制Token流（含符号表与错误，可mmap读取）\n";
+    std::cout << "  --outputs <list>          只写出列出的文本结果：tokens、symbols、errors的逗号分隔组合，\n";
+    std::cout << "                            \"-\"表示都不写（默认全部）；未要求的结果在扫描时就不收集\n";
+    std::cout << "  --symbol-refs             Token结果中的标识符写作(21, #符号id)，id即符号表中的编号\n";
+    std::cout << "  -j, --threads <n>         并行线程数，0表示使用全部CPU核心（默认: 1）；\n";
+    std::cout << "                            单文件时并行扫描该文件，批处理时同时处理多个文件\n";
+    std::cout << "  --batch                   批处理模式：多个输入、目录（递归收集.c/.h）或\n";
+    std::cout << "                            \"-\"（从标准输入逐行读取文件列表）时自动启用；\n";
+    std::cout << "                            每个文件的结果写入输出目录下与输入路径对应的子目录，\n";
+    std::cout << "                            汇总写入summary.txt\n";
+    std::cout << "  --stream                  流式输入：分段读入单个文件或\"-\"（标准输入），内存占用与输入大小无关；\n";
+    std::cout << "                            不支持 --binary、--stats 和结果缓存\n";
+    std::cout << "  --pipeline                流水线流式输入：读入、分析、写出分别在三个线程中重叠进行，\n";
+    std::cout << "                            适合I/O慢的存储（隐含 --stream）\n";
+    std::cout << "  --stats <file>            把运行统计（各阶段耗时、Token类型分布、符号表探测次数、\n";
+    std::cout << "                            峰值内存）以JSON写入输出目录下的该文件\n";
+    std::cout << "  --max-errors <n>          每个文件最多记录n个错误，其余只计数（默认: 0，不限）\n";
+    std::cout << "  --cache-dir <dir>         启用结果缓存：内容未变的输入直接取用上次的结果文件\n";
+    std::cout << "  --cache-limit <MiB>       结果缓存的总大小上限，超出后淘汰最久未用的条目（默认: 1024）\n";
+    std::cout << "  --serve <socket|->        守护进程模式：在Unix域套接字（或\"-\"即标准输入输出）上\n";
+    std::cout << "                            常驻并处理成帧请求，-j 指定同时处理请求的线程数\n";
     std::cout << "  -h, --help                显示此帮助信息\n\n";
     std::cout << "示例:\n";
     std::cout << "  " << programName << " input.c\n";
     std::cout << "  " << programName << " input.c -o custom_output\n";
     std::cout << "  " << programName << " input.c --tokens my_tokens.txt\n";
+    std::cout << "  " << programName << " huge.c -j 0\n";
+    std::cout << "  " << programName << " src/ include/ -j 8 -o out\n";
+    std::cout << "  find . -name '*.c' | " << programName << " - -o out\n";
+    std::cout << "  ./codegen | " << programName << " - --stream -o out\n";
+    std::cout << "  " << programName << " --serve /tmp/lexer.sock -j 0\n";
+}
+
+// 解析完整的非负十进制整数；为空、含其他字符或超出Integer的范围时返回false
+template <typename Integer>
+bool parseCount(const char* text, Integer& value) {
+    const char* end = text + std::strlen(text);
+    auto parsed = std::from_chars(text, end, value);
+    return text != end && parsed.ec == std::errc() && parsed.ptr == end;
 }
 
 Options parseArguments(int argc, char* argv[]) {
@@ -81,23 +148,132 @@ Options parseArguments(int argc, char* argv[]) {
                 return options;
             }
         }
-        else if(arg[0] == '-') {
-            std::cerr << "错误: 未知选项 '" << arg << "'\n";
+        else if(arg == "--binary") {
+            if(i + 1 < argc) {
+                options.binaryFile = argv[++i];
+            } else {
+                std::cerr << "错误: --binary 需要一个参数\n";
+                options.showHelp = true;
+                return options;
+            }
+        }
+        else if(arg == "--outputs") {
+            if(i + 1 < argc && lexer::parseOutputs(argv[i + 1], options.outputs)) {
+                ++i;
+            } else {
+                std::cerr << "错误: --outputs 需要tokens、symbols、errors的逗号分隔组合或\"-\"\n";
+                options.showHelp = true;
+                return options;
+            }
+        }
+        else if(arg == "-j" || arg == "--threads") {
+            if(i + 1 < argc && parseCount(argv[i + 1], options.threads)) {
+                ++i;
+                if(options.threads == 0) {
+                    options.threads = std::max(1u, std::thread::hardware_concurrency());
+                }
+            } else {
+                std::cerr << "错误: " << arg << " 需要一个非负整数参数\n";
+                options.showHelp = true;
+                return options;
+            }
+        }
+        else if(arg == "--stats") {
+#if LEXER_STATS
+            if(i + 1 < argc) {
+                options.statsFile = argv[++i];
+            } else {
+                std::cerr << "错误: --stats 需要一个参数\n";
+                options.showHelp = true;
+                return options;
+            }
+#else
+            std::cerr << "错误: 此构建未启用运行统计（LEXER_ENABLE_STATS=OFF）\n";
             options.showHelp = true;
             return options;
+#endif
         }
-        else {
-            if(options.inputFile.empty()) {
-                options.inputFile = arg;
+        else if(arg == "--cache-dir") {
+            if(i + 1 < argc) {
+                options.cacheDir = argv[++i];
             } else {
-                std::cerr << "错误: 多余的参数 '" << arg << "'\n";
+                std::cerr << "错误: --cache-dir 需要一个参数\n";
                 options.showHelp = true;
                 return options;
             }
         }
+        else if(arg == "--max-errors") {
+            if(i + 1 < argc && parseCount(argv[i + 1], options.maxErrors)) {
+                ++i;
+            } else {
+                std::cerr << "错误: --max-errors 需要一个非负整数参数\n";
+                options.showHelp = true;
+                return options;
+            }
+        }
+        else if(arg == "--cache-limit") {
+            // 换算成字节后仍须能用64位表示
+            if(i + 1 < argc && parseCount(argv[i + 1], options.cacheLimitMiB) &&
+               options.cacheLimitMiB <= (UINT64_MAX >> 20)) {
+                ++i;
+            } else {
+                std::cerr << "错误: --cache-limit 需要一个不超过" << (UINT64_MAX >> 20) << "的非负整数参数\n";
+                options.showHelp = true;
+                return options;
+            }
+        }
+        else if(arg == "--serve") {
+            if(i + 1 < argc) {
+                options.serve = argv[++i];
+            } else {
+                std::cerr << "错误: --serve 需要一个参数\n";
+                options.showHelp = true;
+                return options;
+            }
+        }
+        else if(arg == "--symbol-refs") {
+            options.symbolRefs = true;
+        }
+        else if(arg == "--batch") {
+            options.batch = true;
+        }
+        else if(arg == "--stream") {
+            options.stream = true;
+        }
+        else if(arg == "--pipeline") {
+            options.stream = true;
+            options.pipeline = true;
+        }
+        else if(arg == "-") {
+            options.inputs.push_back(arg);
+            options.batch = true;
+        }
+        else if(arg[0] == '-') {
+            std::cerr << "错误: 未知选项 '" << arg << "'\n";
+            options.showHelp = true;
+            return options;
+        }
+        else {
+            options.inputs.push_back(arg);
+            if(fs::is_directory(arg)) {
+                options.batch = true;
+            }
+        }
     }
     
-    if(options.inputFile.empty() && !options.showHelp) {
+    // --outputs中的refs与--symbol-refs等价
+    options.symbolRefs = options.symbolRefs || (options.outputs & lexer::kSymbolRefs);
+    if(options.symbolRefs) {
+        options.outputs |= lexer::kSymbolRefs;
+    }
+    if(options.inputs.size() > 1) {
+        options.batch = true;
+    }
+    if(!options.inputs.empty()) {
+        options.inputFile = options.inputs.front();
+    }
+    
+    if(options.inputFile.empty() && options.serve.empty() && !options.showHelp) {
         std::cerr << "错误: 未提供输入文件\n";
         options.showHelp = true;
     }
@@ -105,6 +281,273 @@ Options parseArguments(int argc, char* argv[]) {
     return options;
 }
 
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool writeStats(const lexer::StatsCollector& stats, const std::string& path) {
+    try {
+        stats.writeJson(path);
+    } catch(const std::exception& e) {
+        std::cerr << "错误: 写入运行统计失败: " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+int runBatch(const Options& options) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> problems;
+    auto inputs = lexer::collectBatchInputs(options.inputs, problems);
+    for(const auto& problem : problems) {
+        std::cerr << "错误: " << problem << "\n";
+    }
+    
+    try {
+        fs::create_directories(options.outputDir);
+    } catch(const fs::filesystem_error& e) {
+        std::cerr << "错误: 无法创建输出目录 '" << options.outputDir << "': " 
+                  << e.what() << "\n";
+        return 1;
+    }
+    
+    lexer::BatchOptions batchOptions{options.outputDir, options.tokensFile, options.symbolsFile,
+                                     options.errorsFile, options.binaryFile, options.threads,
+                                     options.cacheDir, options.cacheLimitMiB << 20, options.maxErrors,
+                                     options.outputs};
+    lexer::BatchRunner runner(batchOptions);
+    std::unique_ptr<lexer::StatsCollector> stats;
+    if(!options.statsFile.empty()) {
+        stats = std::make_unique<lexer::StatsCollector>();
+    }
+    auto reports = runner.run(inputs, stats.get());
+    if(stats) {
+        stats->setRun("batch", options.threads, secondsSince(start));
+        if(!writeStats(*stats, options.outputDir + "/" + options.statsFile)) {
+            return 1;
+        }
+    }
+    
+    std::string summaryPath = options.outputDir + "/summary.txt";
+    try {
+        runner.writeSummary(reports, summaryPath);
+    } catch(const std::exception& e) {
+        std::cerr << "错误: 写入输出文件失败: " << e.what() << "\n";
+        return 1;
+    }
+    
+    size_t failed = 0, cached = 0, tokens = 0, symbols = 0, errors = 0;
+    for(const auto& report : reports) {
+        cached += report.cached ? 1 : 0;
+        if(report.failed) {
+            failed++;
+            std::cerr << "错误: " << report.path << ": " << report.failure << "\n";
+        }
+        tokens += report.tokens;
+        symbols += report.symbols;
+        errors += report.errors;
+    }
+    
+    std::cout << "批量词法分析完成\n";
+    std::cout << "文件数量: " << reports.size() << "（失败 " << failed << "）\n";
+    if(!options.cacheDir.empty()) {
+        std::cout << "缓存命中: " << cached << "\n";
+    }
+    std::cout << "Token数量: " << tokens << "\n";
+    if(lexer::featuresForOutputs(options.outputs, !options.binaryFile.empty()) & lexer::kInternSymbols) {
+        std::cout << "标识符数量: " << symbols << "\n";
+    } else {
+        std::cout << "标识符数量: 未统计\n";
+    }
+    std::cout << "错误数量: " << errors << "\n";
+    std::cout << "\n汇总已写入: " << summaryPath << "\n";
+    
+    return (failed > 0 || errors > 0 || !problems.empty()) ? 1 : 0;
+}
+
+// 顺序执行的流式分析：Token和错误随窗口逐段写出，符号表在最后写出。路径为空的结果不写
+void lexStream(lexer::StreamLexer& stream, const std::string& tokensPath, const std::string& errorsPath,
+               const std::string& symbolsPath, bool symbolRefs) {
+    std::optional<lexer::OutputWriter> tokensOut;
+    std::optional<lexer::OutputWriter> errorsOut;
+    if(!tokensPath.empty()) {
+        tokensOut.emplace(tokensPath);
+    }
+    if(!errorsPath.empty()) {
+        errorsOut.emplace(errorsPath);
+    }
+    while(stream.next()) {
+        if(tokensOut) {
+            stream.writeTokens(*tokensOut, symbolRefs);
+        }
+        if(errorsOut) {
+            stream.writeErrors(*errorsOut);
+        }
+    }
+    if(tokensOut) {
+        tokensOut->close();
+    }
+    if(errorsOut) {
+        errorsOut->close();
+    }
+    if(!symbolsPath.empty()) {
+        lexer::OutputWriter symbolsOut(symbolsPath);
+        stream.writeSymbolTable(symbolsOut);
+        symbolsOut.close();
+    }
+}
+
+int runStream(const Options& options) {
+    if(options.inputs.size() != 1) {
+        std::cerr << "错误: --stream 只接受一个输入文件或\"-\"\n";
+        return 1;
+    }
+    if(!options.binaryFile.empty() || !options.statsFile.empty()) {
+        std::cerr << "错误: --stream 不支持 --binary 和 --stats\n";
+        return 1;
+    }
+    
+    std::unique_ptr<lexer::StreamLexer> stream;
+    std::unique_ptr<lexer::LexPipeline> pipeline;
+    try {
+        if(options.pipeline) {
+            pipeline = std::make_unique<lexer::LexPipeline>(options.inputFile);
+            pipeline->setErrorLimit(options.maxErrors);
+            pipeline->setSymbolRefs(options.symbolRefs);
+        } else {
+            stream = std::make_unique<lexer::StreamLexer>(options.inputFile);
+            stream->setErrorLimit(options.maxErrors);
+        }
+    } catch(const std::exception&) {
+        std::cerr << "错误: 无法打开文件 '" << options.inputFile << "'\n";
+        return 1;
+    }
+    
+    try {
+        fs::create_directories(options.outputDir);
+    } catch(const fs::filesystem_error& e) {
+        std::cerr << "错误: 无法创建输出目录 '" << options.outputDir << "': " 
+                  << e.what() << "\n";
+        return 1;
+    }
+    
+    auto target = [&](unsigned kind, const std::string& name) {
+        return (options.outputs & kind) ? options.outputDir + "/" + name : std::string();
+    };
+    const std::string tokensPath = target(lexer::kTokensOutput, options.tokensFile);
+    const std::string errorsPath = target(lexer::kErrorsOutput, options.errorsFile);
+    const std::string symbolsPath = target(lexer::kSymbolsOutput, options.symbolsFile);
+    lexer::CachedCounts counts;
+    try {
+        if(pipeline) {
+            pipeline->run(tokensPath, errorsPath, symbolsPath);
+            counts = lexer::CachedCounts{pipeline->getTokenCount(), pipeline->getSymbolCount(),
+                                         pipeline->getErrorCount()};
+        } else {
+            lexStream(*stream, tokensPath, errorsPath, symbolsPath, options.symbolRefs);
+            counts = lexer::CachedCounts{stream->getTokenCount(), stream->getSymbolTable().size(),
+                                         stream->getErrorCount()};
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "错误: " << e.what() << "\n";
+        return 1;
+    }
+    
+    std::cout << "词法分析完成\n";
+    std::cout << "Token数量: " << counts.tokens << "\n";
+    std::cout << "标识符数量: " << counts.symbols << "\n";
+    std::cout << "错误数量: " << counts.errors << "\n";
+    
+    // 错误可能非常多，不再逐条打印
+    if(counts.errors > 0) {
+        if(!errorsPath.empty()) {
+            std::cout << "\n错误详情见: " << errorsPath << "\n";
+        }
+        return 1;
+    }
+    
+    std::cout << "\n输出文件已生成:\n";
+    if(!tokensPath.empty()) {
+        std::cout << "  - " << tokensPath << "\n";
+    }
+    if(!symbolsPath.empty()) {
+        std::cout << "  - " << symbolsPath << "\n";
+    }
+    if(!errorsPath.empty()) {
+        std::cout << "  - " << errorsPath << "\n";
+    }
+    return 0;
+}
+
+int runServer(const Options& options) {
+    lexer::LexerServer server(options.threads, options.maxErrors);
+    try {
+        if(options.serve == "-") {
+            server.serveStream(0, 1);
+        } else {
+            std::cerr << "守护进程已启动，监听 " << options.serve << "\n";
+            server.serveSocket(options.serve);
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "错误: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// 以Features实例分析源码并写出targets中非空的结果；写出失败时返回false
+template <unsigned Features>
+bool lexAndWrite(const Options& options, std::string_view source, const lexer::CacheTargets& targets,
+                 lexer::StatsCollector* stats, lexer::CachedCounts& counts,
+                 std::vector<std::string>& errorLines) {
+    using LexerType = lexer::BasicLexer<Features>;
+    LexerType lex(source);
+    lex.setErrorLimit(options.maxErrors);
+    {
+        lexer::StatsCollector::Phase phase(stats, "tokenize");
+        lexer::ParallelLexer(options.threads).tokenize(lex);
+    }
+    
+    try {
+        if(!targets.tokens.empty()) {
+            lexer::StatsCollector::Phase phase(stats, "write_tokens");
+            lex.writeTokens(targets.tokens, options.symbolRefs);
+        }
+        if(!targets.symbols.empty()) {
+            lexer::StatsCollector::Phase phase(stats, "write_symbol_table");
+            lex.writeSymbolTable(targets.symbols);
+        }
+        if(!targets.errors.empty()) {
+            lexer::StatsCollector::Phase phase(stats, "write_errors");
+            lex.writeErrors(targets.errors);
+        }
+        if constexpr(LexerType::kKeepsTokens && LexerType::kInternsSymbols && LexerType::kCollectsErrors) {
+            if(!targets.binary.empty()) {
+                lexer::StatsCollector::Phase phase(stats, "write_binary");
+                lexer::writeTokenStream(lex, targets.binary);
+            }
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "错误: 写入输出文件失败: " << e.what() << "\n";
+        return false;
+    }
+    if(stats) {
+        stats->addLexer(lex);
+    }
+    
+    counts = lexer::CachedCounts{lex.getTokenCount(), lex.getSymbolTable().size(), lex.getErrorCount()};
+    if constexpr(LexerType::kCollectsErrors) {
+        for(const auto& error : lex.getErrors()) {
+            errorLines.push_back(error.toString(lex.getSource()));
+        }
+        if(counts.errors > lex.getErrors().size()) {
+            errorLines.push_back("另有 " + std::to_string(counts.errors - lex.getErrors().size()) +
+                                 " 个错误超出记录上限，未列出");
+        }
+    }
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     Options options = parseArguments(argc, argv);
     
@@ -113,20 +556,41 @@ int main(int argc, char* argv[]) {
         return options.inputFile.empty() ? 1 : 0;
     }
     
+    if(!options.serve.empty()) {
+        return runServer(options);
+    }
+    
+    if(options.stream) {
+        return runStream(options);
+    }
+    
+    if(options.batch) {
+        return runBatch(options);
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<lexer::StatsCollector> stats;
+    if(!options.statsFile.empty()) {
+        stats = std::make_unique<lexer::StatsCollector>();
+    }
+    
     if(!fs::exists(options.inputFile)) {
         std::cerr << "错误: 文件 '" << options.inputFile << "' 不存在\n";
         return 1;
     }
     
-    std::ifstream inputFile(options.inputFile);
-    if(!inputFile) {
+    // 普通文件直接mmap，源码不再经过流读取和额外拷贝
+    std::unique_ptr<lexer::SourceFile> source;
+    try {
+        lexer::StatsCollector::Phase phase(stats.get(), "read");
+        source = std::make_unique<lexer::SourceFile>(options.inputFile);
+    } catch(const std::exception&) {
         std::cerr << "错误: 无法打开文件 '" << options.inputFile << "'\n";
         return 1;
     }
-    
-    std::string sourceCode((std::istreambuf_iterator<char>(inputFile)),
-                           std::istreambuf_iterator<char>());
-    inputFile.close();
+    if(stats) {
+        stats->addInput(source->view().size());
+    }
     
     try {
         if(!fs::exists(options.outputDir)) {
@@ -138,39 +602,95 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    lexer::Lexer lex(sourceCode);
-    auto tokens = lex.tokenize();
-    
     std::string tokensPath = options.outputDir + "/" + options.tokensFile;
     std::string symbolsPath = options.outputDir + "/" + options.symbolsFile;
     std::string errorsPath = options.outputDir + "/" + options.errorsFile;
+    std::string binaryPath = options.outputDir + "/" + options.binaryFile;
+    const bool withBinary = !options.binaryFile.empty();
+    // 未要求的结果文件路径留空，既不写出也不进缓存
+    lexer::CacheTargets targets{(options.outputs & lexer::kTokensOutput) ? tokensPath : std::string(),
+                                (options.outputs & lexer::kSymbolsOutput) ? symbolsPath : std::string(),
+                                (options.outputs & lexer::kErrorsOutput) ? errorsPath : std::string(),
+                                withBinary ? binaryPath : std::string()};
+    // 文本输出不含Token行列号，扫描时只记偏移；二进制输出写出时再换算
+    const unsigned features = lexer::featuresForOutputs(options.outputs, withBinary);
     
-    try {
-        lex.writeTokens(tokensPath);
-        lex.writeSymbolTable(symbolsPath);
-        lex.writeErrors(errorsPath);
-    } catch(const std::exception& e) {
-        std::cerr << "错误: 写入输出文件失败: " << e.what() << "\n";
-        return 1;
+    std::unique_ptr<lexer::ResultCache> cache;
+    std::string cacheKey;
+    lexer::CachedCounts counts;
+    bool cached = false;
+    if(!options.cacheDir.empty()) {
+        lexer::StatsCollector::Phase phase(stats.get(), "cache_lookup");
+        cache = std::make_unique<lexer::ResultCache>(options.cacheDir, options.cacheLimitMiB << 20);
+        cacheKey = lexer::ResultCache::key(source->view(), withBinary, options.outputs, options.maxErrors);
+        cached = cache->fetch(cacheKey, targets, counts);
+        if(cached && stats) {
+            stats->addCachedFile();
+        }
+    }
+    
+    std::vector<std::string> errorLines;
+    if(cached) {
+        // 错误文件的每一行与LexicalError::toString()相同
+        if(counts.errors > 0 && !targets.errors.empty()) {
+            std::ifstream errorsFile(errorsPath);
+            for(std::string line; std::getline(errorsFile, line);) {
+                errorLines.push_back(line);
+            }
+        }
+    } else {
+        bool written = lexer::withLexerFeatures(features, [&](auto variant) {
+            return lexAndWrite<decltype(variant)::value>(options, source->view(), targets, stats.get(),
+                                                         counts, errorLines);
+        });
+        if(!written) {
+            return 1;
+        }
+        if(cache) {
+            cache->store(cacheKey, targets, counts);
+            cache->evict();
+        }
+    }
+    
+    if(stats) {
+        stats->setRun("single", options.threads, secondsSince(start));
+        if(!writeStats(*stats, options.outputDir + "/" + options.statsFile)) {
+            return 1;
+        }
     }
     
     std::cout << "词法分析完成\n";
-    std::cout << "Token数量: " << tokens.size() << "\n";
-    std::cout << "标识符数量: " << lex.getSymbolTable().size() << "\n";
-    std::cout << "错误数量: " << lex.getErrors().size() << "\n";
+    std::cout << "Token数量: " << counts.tokens << "\n";
+    if(features & lexer::kInternSymbols) {
+        std::cout << "标识符数量: " << counts.symbols << "\n";
+    } else {
+        std::cout << "标识符数量: 未统计\n";
+    }
+    std::cout << "错误数量: " << counts.errors << "\n";
     
-    if(lex.hasErrors()) {
-        std::cout << "\n发现以下错误:\n";
-        for(const auto& error : lex.getErrors()) {
-            std::cout << "  " << error.toString() << "\n";
+    if(counts.errors > 0) {
+        // 未要求错误结果时不记录错误，只有数量
+        if(!errorLines.empty()) {
+            std::cout << "\n发现以下错误:\n";
+            for(const auto& line : errorLines) {
+                std::cout << "  " << line << "\n";
+            }
         }
         return 1;
     }
     
     std::cout << "\n输出文件已生成:\n";
-    std::cout << "  - " << tokensPath << "\n";
-    std::cout << "  - " << symbolsPath << "\n";
-    std::cout << "  - " << errorsPath << "\n";
+    for(const auto* path : {&targets.tokens, &targets.symbols, &targets.errors}) {
+        if(!path->empty()) {
+            std::cout << "  - " << *path << "\n";
+        }
+    }
+    if(withBinary) {
+        std::cout << "  - " << binaryPath << "\n";
+    }
+    if(stats) {
+        std::cout << "  - " << options.outputDir << "/" << options.statsFile << "\n";
+    }
     
     return 0;
 }
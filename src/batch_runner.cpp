@@ -0,0 +1,306 @@
+#include "batch_runner.h"
+#include "lexer.h"
+#include "source_file.h"
+#include "thread_pool.h"
+#include "token_stream.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace lexer {
+
+namespace {
+
+bool isSourceFile(const fs::path& path) {
+    return path.extension() == ".c" || path.extension() == ".h";
+}
+
+// 去掉根目录和".."，使结果总能落在输出根目录之内
+std::string sanitizeKey(const fs::path& path) {
+    fs::path key;
+    for(const auto& part : path.lexically_normal().relative_path()) {
+        if(part != ".." && part != ".") {
+            key /= part;
+        }
+    }
+    return key.empty() ? path.filename().string() : key.string();
+}
+
+// 已收集的文件（按规范化路径）和已占用的输出子目录。同一文件以不同写法
+// （"src"、"src/f.c"、"./src/f.c"）多次给出时只分析一次；不同文件的子目录相同时
+// 后来者加上"~序号"后缀，免得多个任务同时写同一组结果文件
+struct InputSet {
+    std::unordered_set<std::string> files;
+    std::unordered_set<std::string> keys;
+};
+
+void addFile(const fs::path& path, std::string key, InputSet& seen, std::vector<BatchInput>& inputs,
+             std::vector<std::string>& problems) {
+    std::error_code ec;
+    auto size = fs::file_size(path, ec);
+    if(ec) {
+        problems.push_back(path.string() + ": " + ec.message());
+        return;
+    }
+    fs::path canonical = fs::weakly_canonical(path, ec);
+    if(!seen.files.insert(ec ? fs::absolute(path).lexically_normal().string() : canonical.string()).second) {
+        return;
+    }
+    if(!seen.keys.insert(key).second) {
+        std::string unique;
+        for(size_t n = 2; !seen.keys.insert(unique = key + "~" + std::to_string(n)).second; ++n) {
+        }
+        key = unique;
+    }
+    inputs.push_back(BatchInput{path.string(), key, static_cast<size_t>(size)});
+}
+
+void addPath(const std::string& path, InputSet& seen, std::vector<BatchInput>& inputs,
+             std::vector<std::string>& problems) {
+    std::error_code ec;
+    if(!fs::is_directory(path, ec)) {
+        if(!fs::exists(path, ec)) {
+            problems.push_back(path + ": 文件不存在");
+            return;
+        }
+        addFile(path, sanitizeKey(path), seen, inputs, problems);
+        return;
+    }
+    
+    std::vector<fs::path> files;
+    for(auto it = fs::recursive_directory_iterator(path, ec);
+        !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if(it->is_regular_file(ec) && isSourceFile(it->path())) {
+            files.push_back(it->path());
+        }
+    }
+    if(ec) {
+        problems.push_back(path + ": " + ec.message());
+    }
+    std::sort(files.begin(), files.end());
+    for(const auto& file : files) {
+        addFile(file, sanitizeKey(fs::path(path).filename() / file.lexically_relative(path)), seen,
+                inputs, problems);
+    }
+}
+
+}
+
+std::vector<BatchInput> collectBatchInputs(const std::vector<std::string>& paths,
+                                           std::vector<std::string>& problems) {
+    std::vector<BatchInput> inputs;
+    InputSet seen;
+    for(const auto& path : paths) {
+        if(path == "-") {
+            std::string line;
+            while(std::getline(std::cin, line)) {
+                if(!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                if(!line.empty()) {
+                    addPath(line, seen, inputs, problems);
+                }
+            }
+        } else {
+            addPath(path, seen, inputs, problems);
+        }
+    }
+    return inputs;
+}
+
+BatchRunner::BatchRunner(const BatchOptions& options) : options_(options) {
+    if(!options_.cacheDir.empty()) {
+        cache_ = std::make_unique<ResultCache>(options_.cacheDir, options_.cacheLimit);
+    }
+}
+
+template <unsigned Features>
+FileReport BatchRunner::processFile(const BatchInput& input, BasicLexer<Features>& lex,
+                                    StatsCollector* stats) const {
+    FileReport report;
+    report.path = input.path;
+    report.outputDir = (fs::path(options_.outputDir) / input.outputKey).string();
+    try {
+        std::unique_ptr<SourceFile> source;
+        {
+            StatsCollector::Phase phase(stats, "read");
+            source = std::make_unique<SourceFile>(input.path);
+        }
+        fs::create_directories(report.outputDir);
+        report.bytes = source->view().size();
+        if(stats) {
+            stats->addInput(report.bytes);
+        }
+        
+        auto target = [&](bool wanted, const std::string& name) {
+            return wanted ? report.outputDir + "/" + name : std::string();
+        };
+        CacheTargets targets{target(options_.outputs & kTokensOutput, options_.tokensFile),
+                             target(options_.outputs & kSymbolsOutput, options_.symbolsFile),
+                             target(options_.outputs & kErrorsOutput, options_.errorsFile),
+                             target(!options_.binaryFile.empty(), options_.binaryFile)};
+        std::string cacheKey;
+        CachedCounts counts;
+        if(cache_) {
+            StatsCollector::Phase phase(stats, "cache_lookup");
+            cacheKey = ResultCache::key(source->view(), !targets.binary.empty(), options_.outputs,
+                                        options_.maxErrors);
+            if(cache_->fetch(cacheKey, targets, counts)) {
+                report.tokens = counts.tokens;
+                report.symbols = counts.symbols;
+                report.errors = counts.errors;
+                report.cached = true;
+                if(stats) {
+                    stats->addCachedFile();
+                }
+                return report;
+            }
+        }
+        
+        lex.reset(source->view());
+        lex.setErrorLimit(options_.maxErrors);
+        {
+            StatsCollector::Phase phase(stats, "tokenize");
+            lex.tokenize();
+        }
+        if(!targets.tokens.empty()) {
+            StatsCollector::Phase phase(stats, "write_tokens");
+            lex.writeTokens(targets.tokens, (options_.outputs & kSymbolRefs) != 0);
+        }
+        if(!targets.symbols.empty()) {
+            StatsCollector::Phase phase(stats, "write_symbol_table");
+            lex.writeSymbolTable(targets.symbols);
+        }
+        if(!targets.errors.empty()) {
+            StatsCollector::Phase phase(stats, "write_errors");
+            lex.writeErrors(targets.errors);
+        }
+        using LexerType = BasicLexer<Features>;
+        if constexpr(LexerType::kKeepsTokens && LexerType::kInternsSymbols && LexerType::kCollectsErrors) {
+            if(!targets.binary.empty()) {
+                StatsCollector::Phase phase(stats, "write_binary");
+                writeTokenStream(lex, targets.binary);
+            }
+        }
+        if(stats) {
+            stats->addLexer(lex);
+        }
+        
+        report.tokens = lex.getTokenCount();
+        report.symbols = lex.getSymbolTable().size();
+        report.errors = lex.getErrorCount();
+        if(cache_) {
+            cache_->store(cacheKey, targets, CachedCounts{report.tokens, report.symbols, report.errors});
+        }
+    } catch(const std::exception& e) {
+        report.failed = true;
+        report.failure = e.what();
+    }
+    return report;
+}
+
+std::vector<FileReport> BatchRunner::run(const std::vector<BatchInput>& inputs,
+                                         StatsCollector* stats) const {
+    std::vector<FileReport> reports(inputs.size());
+    std::mutex statsMutex;
+    ThreadPool pool(options_.threads);
+    struct Task {
+        size_t first;
+        size_t last;
+        std::future<void> done;
+    };
+    std::vector<Task> tasks;
+    
+    size_t first = 0;
+    while(first < inputs.size()) {
+        size_t last = first;
+        size_t bytes = 0;
+        while(last < inputs.size() && last - first < kTaskFiles &&
+              (last == first || bytes + inputs[last].size <= kTaskBytes)) {
+            bytes += inputs[last].size;
+            last++;
+        }
+        std::future<void> done = pool.submit([this, &inputs, &reports, &statsMutex, stats, first, last]() {
+            // 每个任务先收集到局部统计，结束时合并一次
+            StatsCollector local;
+            withLexerFeatures(featuresForOutputs(options_.outputs, !options_.binaryFile.empty()),
+                              [&](auto variant) {
+                BasicLexer<decltype(variant)::value> lex{std::string_view()};
+                for(size_t i = first; i < last; ++i) {
+                    reports[i] = processFile(inputs[i], lex, stats ? &local : nullptr);
+                }
+            });
+            if(stats) {
+                std::lock_guard<std::mutex> lock(statsMutex);
+                stats->merge(local);
+            }
+        });
+        tasks.push_back(Task{first, last, std::move(done)});
+        first = last;
+    }
+    pool.wait();
+    // processFile自己捕获分析中的异常；逃出任务的异常（如创建Lexer时内存不足）
+    // 只让该任务中尚未完成的文件记为失败，不影响其余文件
+    for(auto& task : tasks) {
+        std::string failure;
+        try {
+            task.done.get();
+            continue;
+        } catch(const std::exception& e) {
+            failure = e.what();
+        } catch(...) {
+            failure = "未知错误";
+        }
+        for(size_t i = task.first; i < task.last; ++i) {
+            if(reports[i].path.empty()) {
+                reports[i].path = inputs[i].path;
+                reports[i].outputDir = (fs::path(options_.outputDir) / inputs[i].outputKey).string();
+                reports[i].failed = true;
+                reports[i].failure = failure;
+            }
+        }
+    }
+    if(cache_) {
+        cache_->evict();
+    }
+    return reports;
+}
+
+void BatchRunner::writeSummary(const std::vector<FileReport>& reports,
+                               const std::string& filepath) const {
+    std::ofstream outFile(filepath);
+    if(!outFile) {
+        throw std::runtime_error("无法创建文件: " + filepath);
+    }
+    // 不登记符号时标识符数一栏记为"-"
+    const bool symbolsCounted =
+        (featuresForOutputs(options_.outputs, !options_.binaryFile.empty()) & kInternSymbols) != 0;
+    auto symbolColumn = [&](size_t count) {
+        return symbolsCounted ? std::to_string(count) : std::string("-");
+    };
+    size_t failed = 0, bytes = 0, tokens = 0, symbols = 0, errors = 0;
+    outFile << "# 路径\t字节数\tToken数\t标识符数\t错误数\t状态\n";
+    for(const auto& report : reports) {
+        outFile << report.path << "\t" << report.bytes << "\t" << report.tokens << "\t"
+                << symbolColumn(report.symbols) << "\t" << report.errors << "\t"
+                << (report.failed ? "失败: " + report.failure : report.cached ? "完成（缓存）" : "完成")
+                << "\n";
+        failed += report.failed ? 1 : 0;
+        bytes += report.bytes;
+        tokens += report.tokens;
+        symbols += report.symbols;
+        errors += report.errors;
+    }
+    outFile << "# 合计\t" << bytes << "\t" << tokens << "\t" << symbolColumn(symbols) << "\t" << errors
+            << "\t文件 " << reports.size() << "，失败 " << failed << "\n";
+}
+
+}
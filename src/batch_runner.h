@@ -0,0 +1,75 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "lexer_features.h"
+#include "lexer_stats.h"
+#include "result_cache.h"
+
+namespace lexer {
+
+struct BatchOptions {
+    std::string outputDir;
+    std::string tokensFile;
+    std::string symbolsFile;
+    std::string errorsFile;
+    std::string binaryFile;     // 为空时不输出二进制Token流
+    size_t threads;
+    std::string cacheDir;       // 为空时不使用结果缓存
+    std::uint64_t cacheLimit;   // 结果缓存的总大小上限（字节）
+    size_t maxErrors;           // 每个文件最多记录的错误数，0表示不限
+    unsigned outputs;           // 要写出的文本结果（OutputKind的组合）
+};
+
+struct BatchInput {
+    std::string path;
+    std::string outputKey;      // 相对输出根目录的子目录
+    size_t size;
+};
+
+struct FileReport {
+    std::string path;
+    std::string outputDir;
+    size_t bytes = 0;
+    size_t tokens = 0;
+    size_t symbols = 0;
+    size_t errors = 0;
+    bool cached = false;        // 结果直接取自缓存
+    bool failed = false;
+    std::string failure;
+};
+
+// 展开批处理输入：目录递归收集其中的.c/.h文件，"-"表示从标准输入逐行读取文件列表。
+// 同一文件只收集一次，各文件的输出子目录互不相同。无法访问的路径记入problems
+std::vector<BatchInput> collectBatchInputs(const std::vector<std::string>& paths,
+                                           std::vector<std::string>& problems);
+
+// 在工作窃取线程池上批量分析多个文件，每个文件的结果写入输出根目录下各自的子目录。
+// 小文件按总大小打包成一个任务，避免调度开销超过分析本身
+class BatchRunner {
+public:
+    explicit BatchRunner(const BatchOptions& options);
+    
+    // 返回的报告与inputs一一对应；stats非空时汇总各文件的统计
+    std::vector<FileReport> run(const std::vector<BatchInput>& inputs,
+                                StatsCollector* stats = nullptr) const;
+    void writeSummary(const std::vector<FileReport>& reports, const std::string& filepath) const;
+    
+private:
+    static constexpr size_t kTaskBytes = 256 * 1024;
+    static constexpr size_t kTaskFiles = 64;
+    
+    BatchOptions options_;
+    std::unique_ptr<ResultCache> cache_;
+    
+    // lex在同一任务的各文件间复用，其功能组合由要求的结果决定
+    template <unsigned Features>
+    FileReport processFile(const BatchInput& input, BasicLexer<Features>& lex, StatsCollector* stats) const;
+};
+
+}
+
+#endif
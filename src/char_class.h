@@ -0,0 +1,162 @@
+#ifndef CHAR_CLASS_H
+#define CHAR_CLASS_H
+
+#include <array>
+#include <cstdint>
+#include "token_types.h"
+
+namespace lexer {
+
+// 主扫描循环按字符类别分派，每个字节只需一次查表
+enum class CharClass : std::uint8_t {
+    ILLEGAL,        // 不属于C语言子集的字符
+    END,            // '\0'：与逐字符扫描时一样视为输入结束
+    WHITESPACE,
+    IDENT_START,
+    DIGIT,
+    SLASH,          // '/'：除号、/=或注释开头
+    OPERATOR,       // 其余运算符和分界符
+};
+
+namespace detail {
+
+constexpr bool isAsciiAlpha(int c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+constexpr bool isAsciiDigit(int c) {
+    return c >= '0' && c <= '9';
+}
+
+constexpr std::array<CharClass, 256> makeCharClassTable() {
+    std::array<CharClass, 256> table{};
+    for(int c = 0; c < 256; ++c) {
+        if(isAsciiAlpha(c) || c == '_') {
+            table[c] = CharClass::IDENT_START;
+        } else if(isAsciiDigit(c)) {
+            table[c] = CharClass::DIGIT;
+        } else {
+            table[c] = CharClass::ILLEGAL;
+        }
+    }
+    table['\0'] = CharClass::END;
+    table[' '] = table['\t'] = table['\n'] = table['\r'] = CharClass::WHITESPACE;
+    table['/'] = CharClass::SLASH;
+    for(char c : {'+', '-', '*', '=', '<', '>', '!', '&', '|', ';', ',', '(', ')', '{', '}'}) {
+        table[static_cast<unsigned char>(c)] = CharClass::OPERATOR;
+    }
+    return table;
+}
+
+constexpr std::array<bool, 256> makeIdentCharTable() {
+    std::array<bool, 256> table{};
+    for(int c = 0; c < 256; ++c) {
+        table[c] = isAsciiAlpha(c) || isAsciiDigit(c) || c == '_';
+    }
+    return table;
+}
+
+constexpr std::array<TokenType, 256> makeSingleOperatorTable() {
+    std::array<TokenType, 256> table{};
+    for(auto& type : table) {
+        type = TokenType::ERROR;
+    }
+    table['+'] = TokenType::PLUS;
+    table['-'] = TokenType::MINUS;
+    table['*'] = TokenType::MULTIPLY;
+    table['/'] = TokenType::DIVIDE;
+    table['='] = TokenType::ASSIGN;
+    table['<'] = TokenType::LT;
+    table['>'] = TokenType::GT;
+    table['!'] = TokenType::NOT;
+    table[';'] = TokenType::SEMICOLON;
+    table[','] = TokenType::COMMA;
+    table['('] = TokenType::LPAREN;
+    table[')'] = TokenType::RPAREN;
+    table['{'] = TokenType::LBRACE;
+    table['}'] = TokenType::RBRACE;
+    return table;
+}
+
+// 双字符运算符的转移表按“首字符行 × 次字符列”压缩存储，避免256×256的稀疏表
+constexpr const char kOperatorRows[] = " +-*/=<>!&|";
+constexpr const char kOperatorColumns[] = " +-=<>&|";
+constexpr int kOperatorRowCount = sizeof(kOperatorRows) - 1;
+constexpr int kOperatorColumnCount = sizeof(kOperatorColumns) - 1;
+
+constexpr std::array<std::uint8_t, 256> makeIndexTable(const char* chars) {
+    std::array<std::uint8_t, 256> table{};
+    for(int i = 1; chars[i] != '\0'; ++i) {
+        table[static_cast<unsigned char>(chars[i])] = static_cast<std::uint8_t>(i);
+    }
+    return table;
+}
+
+using OperatorPairTable =
+    std::array<std::array<TokenType, kOperatorColumnCount>, kOperatorRowCount>;
+
+constexpr OperatorPairTable makeOperatorPairTable() {
+    OperatorPairTable table{};
+    for(auto& row : table) {
+        for(auto& type : row) {
+            type = TokenType::ERROR;
+        }
+    }
+    constexpr auto rows = makeIndexTable(kOperatorRows);
+    constexpr auto columns = makeIndexTable(kOperatorColumns);
+    struct Pair {
+        char first;
+        char second;
+        TokenType type;
+    };
+    constexpr Pair pairs[] = {
+        {'+', '+', TokenType::INCREMENT},   {'+', '=', TokenType::PLUS_ASSIGN},
+        {'-', '-', TokenType::DECREMENT},   {'-', '=', TokenType::MINUS_ASSIGN},
+        {'*', '=', TokenType::MULTIPLY_ASSIGN}, {'/', '=', TokenType::DIVIDE_ASSIGN},
+        {'=', '=', TokenType::EQUAL},       {'!', '=', TokenType::NOT_EQUAL},
+        {'<', '=', TokenType::LE},          {'<', '<', TokenType::LEFT_SHIFT},
+        {'>', '=', TokenType::GE},          {'>', '>', TokenType::RIGHT_SHIFT},
+        {'&', '&', TokenType::AND},         {'|', '|', TokenType::OR},
+    };
+    for(const auto& pair : pairs) {
+        table[rows[static_cast<unsigned char>(pair.first)]]
+             [columns[static_cast<unsigned char>(pair.second)]] = pair.type;
+    }
+    return table;
+}
+
+}
+
+inline constexpr std::array<CharClass, 256> kCharClass = detail::makeCharClassTable();
+inline constexpr std::array<bool, 256> kIdentChar = detail::makeIdentCharTable();
+
+// 单字符运算符的类型；'&'和'|'单独出现时为非法字符，记为ERROR
+inline constexpr std::array<TokenType, 256> kSingleOperator = detail::makeSingleOperatorTable();
+
+inline constexpr std::array<std::uint8_t, 256> kOperatorRow =
+    detail::makeIndexTable(detail::kOperatorRows);
+inline constexpr std::array<std::uint8_t, 256> kOperatorColumn =
+    detail::makeIndexTable(detail::kOperatorColumns);
+inline constexpr detail::OperatorPairTable kOperatorPair = detail::makeOperatorPairTable();
+
+inline CharClass classify(char c) {
+    return kCharClass[static_cast<unsigned char>(c)];
+}
+
+inline bool isIdentChar(char c) {
+    return kIdentChar[static_cast<unsigned char>(c)];
+}
+
+inline bool isDigitChar(char c) {
+    return classify(c) == CharClass::DIGIT;
+}
+
+// 查双字符运算符转移表，不构成双字符运算符时返回ERROR
+inline TokenType operatorPair(char first, char second) {
+    return kOperatorPair[kOperatorRow[static_cast<unsigned char>(first)]]
+                        [kOperatorColumn[static_cast<unsigned char>(second)]];
+}
+
+}
+
+#endif
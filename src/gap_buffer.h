@@ -0,0 +1,176 @@
+#ifndef GAP_BUFFER_H
+#define GAP_BUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace lexer {
+
+// 间隙缓冲：内容存放在空位两侧，空位留在最近一次编辑处。在空位附近替换只需搬动空位经过的
+// 部分，在同一区域连续编辑时代价与两次编辑的距离成正比，与编辑点之后的长度无关。
+// 供IncrementalLexer保存源码（GapString）以及Token和错误（ShiftedGapVector）
+
+class GapString {
+public:
+    explicit GapString(std::string text)
+        : buffer_(std::move(text)), gapBegin_(buffer_.size()), gapEnd_(buffer_.size()) {
+    }
+    
+    size_t size() const {
+        return buffer_.size() - (gapEnd_ - gapBegin_);
+    }
+    
+    // 空位之前、之后各自连续的内容
+    std::string_view before() const {
+        return std::string_view(buffer_.data(), gapBegin_);
+    }
+    
+    std::string_view after() const {
+        return std::string_view(buffer_.data() + gapEnd_, buffer_.size() - gapEnd_);
+    }
+    
+    // 空位移到末尾后的完整内容
+    std::string_view view() {
+        moveGap(size());
+        return before();
+    }
+    
+    void moveGap(size_t position) {
+        char* data = &buffer_[0];
+        if(position < gapBegin_) {
+            size_t count = gapBegin_ - position;
+            std::memmove(data + gapEnd_ - count, data + position, count);
+            gapBegin_ -= count;
+            gapEnd_ -= count;
+        } else if(position > gapBegin_) {
+            size_t count = position - gapBegin_;
+            std::memmove(data + gapBegin_, data + gapEnd_, count);
+            gapBegin_ += count;
+            gapEnd_ += count;
+        }
+    }
+    
+    // 把[position, position + removed)替换为inserted，空位随后紧跟在插入的内容之后
+    void replace(size_t position, size_t removed, std::string_view inserted) {
+        moveGap(position);
+        gapEnd_ += removed;
+        if(gapEnd_ - gapBegin_ < inserted.size()) {
+            // 空位按内容长度的一半扩大，扩大的代价分摊到之后的编辑
+            size_t gap = std::max(inserted.size(), size() / 2 + kMinGap);
+            size_t tail = buffer_.size() - gapEnd_;
+            std::string grown(gapBegin_ + gap + tail, '\0');
+            std::memcpy(&grown[0], buffer_.data(), gapBegin_);
+            std::memcpy(&grown[0] + gapBegin_ + gap, buffer_.data() + gapEnd_, tail);
+            buffer_.swap(grown);
+            gapEnd_ = gapBegin_ + gap;
+        }
+        std::memcpy(&buffer_[0] + gapBegin_, inserted.data(), inserted.size());
+        gapBegin_ += inserted.size();
+    }
+
+private:
+    static constexpr size_t kMinGap = 4096;
+    
+    std::string buffer_;
+    size_t gapBegin_;
+    size_t gapEnd_;
+};
+
+// 按位置排列、带行号和偏移的元素序列（Token、错误）。空位之前的元素位置是最终的，空位之后的
+// 还差一个统一的（偏移，行号）平移：编辑点之后的元素整体平移时只累加这两个差值，
+// 取出时才加上；元素跨过空位时加上或去掉这一平移。T须提供shifted(偏移差, 行差, 列差)和getLine()
+template <typename T>
+class ShiftedGapVector {
+public:
+    explicit ShiftedGapVector(std::vector<T> items)
+        : items_(std::move(items)), gapBegin_(items_.size()), gapEnd_(items_.size()), offsetShift_(0),
+          lineShift_(0) {
+    }
+    
+    size_t size() const {
+        return items_.size() - (gapEnd_ - gapBegin_);
+    }
+    
+    T operator[](size_t index) const {
+        if(index < gapBegin_) {
+            return items_[index];
+        }
+        return items_[index + gapEnd_ - gapBegin_].shifted(offsetShift_, lineShift_, 0);
+    }
+    
+    // 替换第index个元素，value的位置是最终的
+    void set(size_t index, const T& value) {
+        if(index < gapBegin_) {
+            items_[index] = value;
+        } else {
+            items_[index + gapEnd_ - gapBegin_] = value.shifted(-offsetShift_, -lineShift_, 0);
+        }
+    }
+    
+    // 把[first, last)替换为replacement（位置是最终的），last之后的元素再平移(offsetDelta, lineDelta)
+    void replace(size_t first, size_t last, const std::vector<T>& replacement, std::ptrdiff_t offsetDelta,
+                 int lineDelta) {
+        moveGap(last);
+        gapBegin_ = first;
+        if(gapEnd_ - gapBegin_ < replacement.size()) {
+            size_t gap = std::max(replacement.size(), size() / 2 + kMinGap);
+            std::vector<T> grown;
+            grown.reserve(gapBegin_ + gap + items_.size() - gapEnd_);
+            grown.insert(grown.end(), items_.begin(), items_.begin() + static_cast<std::ptrdiff_t>(gapBegin_));
+            grown.resize(gapBegin_ + gap, replacement.front());
+            grown.insert(grown.end(), items_.begin() + static_cast<std::ptrdiff_t>(gapEnd_), items_.end());
+            items_.swap(grown);
+            gapEnd_ = gapBegin_ + gap;
+        }
+        std::copy(replacement.begin(), replacement.end(), items_.begin() + static_cast<std::ptrdiff_t>(gapBegin_));
+        gapBegin_ += replacement.size();
+        offsetShift_ += offsetDelta;
+        lineShift_ += lineDelta;
+    }
+    
+    // 从first起位于line行的元素列号加上columnDelta（同步点所在行上的列号随编辑变化）
+    void shiftColumns(size_t first, int line, int columnDelta) {
+        for(size_t i = first; i < size() && (*this)[i].getLine() == line; ++i) {
+            set(i, (*this)[i].shifted(0, 0, columnDelta));
+        }
+    }
+    
+    // 合上空位，返回连续存放的全部元素；代价与空位之后的元素数成正比
+    const std::vector<T>& materialize() {
+        moveGap(size());
+        items_.erase(items_.begin() + static_cast<std::ptrdiff_t>(gapBegin_), items_.end());
+        gapEnd_ = gapBegin_;
+        return items_;
+    }
+
+private:
+    static constexpr size_t kMinGap = 256;
+    
+    std::vector<T> items_;
+    size_t gapBegin_;
+    size_t gapEnd_;
+    std::ptrdiff_t offsetShift_;
+    int lineShift_;
+    
+    void moveGap(size_t index) {
+        while(gapBegin_ > index) {
+            --gapBegin_;
+            --gapEnd_;
+            items_[gapEnd_] = items_[gapBegin_].shifted(-offsetShift_, -lineShift_, 0);
+        }
+        while(gapBegin_ < index) {
+            items_[gapBegin_] = items_[gapEnd_].shifted(offsetShift_, lineShift_, 0);
+            ++gapBegin_;
+            ++gapEnd_;
+        }
+    }
+};
+
+}
+
+#endif
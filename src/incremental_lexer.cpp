@@ -0,0 +1,297 @@
+#include "incremental_lexer.h"
+#include "simd_scan.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace lexer {
+
+namespace {
+
+// 位置按（行，列）比较，与偏移顺序一致
+bool positionAfter(int line, int column, int otherLine, int otherColumn) {
+    return line > otherLine || (line == otherLine && column > otherColumn);
+}
+
+void requireNoNul(std::string_view text) {
+    if(std::memchr(text.data(), '\0', text.size())) {
+        throw std::invalid_argument("增量分析的源码不能包含'\\\\0'");
+    }
+}
+
+// Token在源码中实际占据的末尾：过长的标识符只保留32个字符，但扫描一直读到标识符结束。
+// text为源码开头的一段，超出text的部分不计
+size_t tokenEnd(const Token& token, std::string_view text) {
+    if(token.getType() == TokenType::IDENTIFIER) {
+        const char* data = text.data();
+        return static_cast<size_t>(simd::skipIdentChars(data + token.getOffset(), data + text.size()) - data);
+    }
+    return token.getOffset() + token.getValue(text).size();
+}
+
+// 重扫的分析器：不登记符号，换入Token流后再在持久的符号表中登记
+using RelexLexer = BasicLexer<kAllFeatures & ~kInternSymbols>;
+
+// 各项的偏移加上base：重扫绑定在从base开始的一段源码上
+template <typename Sequence>
+std::vector<Sequence> shiftedBy(const std::vector<Sequence>& items, size_t base) {
+    std::vector<Sequence> result;
+    result.reserve(items.size());
+    for(const auto& item : items) {
+        result.push_back(item.shifted(static_cast<std::ptrdiff_t>(base), 0, 0));
+    }
+    return result;
+}
+
+}
+
+IncrementalLexer::IncrementalLexer(std::string source)
+    : source_(std::move(source)), tokens_({}), errors_({}), lastRelexed_(0), deadSymbols_(0) {
+    std::string_view text = source_.view();
+    requireNoNul(text);
+    RelexLexer lex{text};
+    lex.deferOpenComment_ = true;
+    std::vector<Token> tokens = lex.tokenize();
+    std::vector<LexicalError> errors = lex.errors_;
+    if(lex.commentOpen_) {
+        errors.emplace_back(ErrorCode::UNTERMINATED_COMMENT, lex.openCommentOffset_, 0, lex.openCommentLine_,
+                            lex.openCommentColumn_);
+    }
+    lastRelexed_ = tokens.size();
+    tokens_ = ShiftedGapVector<Token>(std::move(tokens));
+    errors_ = ShiftedGapVector<LexicalError>(std::move(errors));
+    rebuildSymbols();
+}
+
+size_t IncrementalLexer::firstTokenFrom(size_t first, size_t offset) const {
+    size_t last = tokens_.size();
+    while(first < last) {
+        size_t middle = first + (last - first) / 2;
+        if(tokens_[middle].getOffset() < offset) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+size_t IncrementalLexer::firstErrorAfter(int line, int column) const {
+    size_t first = 0;
+    size_t last = errors_.size();
+    while(first < last) {
+        size_t middle = first + (last - first) / 2;
+        LexicalError error = errors_[middle];
+        if(positionAfter(error.getLine(), error.getColumn(), line, column)) {
+            last = middle;
+        } else {
+            first = middle + 1;
+        }
+    }
+    return first;
+}
+
+void IncrementalLexer::internToken(Token& token, std::string_view text, size_t base) {
+    Token local = token.shifted(-static_cast<std::ptrdiff_t>(base), 0, 0);
+    int id = symbols_.insert(local.getValue(text));
+    if(static_cast<size_t>(id) == symbolUses_.size()) {
+        symbolUses_.push_back(0);
+    } else if(symbolUses_[static_cast<size_t>(id)] == 0) {
+        deadSymbols_--;
+    }
+    symbolUses_[static_cast<size_t>(id)]++;
+    token = token.withSymbolId(id);
+}
+
+void IncrementalLexer::releaseSymbol(int id) {
+    if(--symbolUses_[static_cast<size_t>(id)] == 0) {
+        deadSymbols_++;
+    }
+}
+
+void IncrementalLexer::rebuildSymbols() {
+    symbols_.clear();
+    symbolUses_.clear();
+    deadSymbols_ = 0;
+    std::string_view text = source_.view();
+    for(size_t i = 0; i < tokens_.size(); ++i) {
+        Token token = tokens_[i];
+        if(token.getType() == TokenType::IDENTIFIER) {
+            internToken(token, text, 0);
+            tokens_.set(i, token);
+        }
+    }
+}
+
+void IncrementalLexer::applyEdit(size_t offset, size_t removedLength, std::string_view insertedText) {
+    if(offset > source_.size() || removedLength > source_.size() - offset) {
+        throw std::out_of_range("编辑范围超出源码");
+    }
+    requireNoNul(insertedText);
+    if(source_.size() - removedLength + insertedText.size() > UINT32_MAX) {
+        throw std::length_error("源码超过4GiB，超出Token偏移范围");
+    }
+    
+    // 从编辑点之前最后一个（含向前查看的字符在内）完全不受影响的Token开始重扫：
+    // Token起点是唯一确知“不在注释内”的位置。空位移到编辑点，之前的源码连续存放
+    source_.moveGap(offset);
+    const std::string_view before = source_.before();
+    size_t restartIndex = firstTokenFrom(0, offset);
+    while(restartIndex > 0 && tokenEnd(tokens_[restartIndex - 1], before) >= offset) {
+        --restartIndex;
+    }
+    bool fromStart = restartIndex == 0;
+    if(!fromStart) {
+        --restartIndex;
+    }
+    const Token restart = tokens_[restartIndex];
+    size_t restartOffset = fromStart ? 0 : restart.getOffset();
+    int restartLine = fromStart ? 1 : restart.getLine();
+    int restartColumn = fromStart ? 0 : restart.getColumn();
+    
+    const size_t oldEditEnd = offset + removedLength;
+    const size_t newEditEnd = offset + insertedText.size();
+    const std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(insertedText.size()) -
+                                 static_cast<std::ptrdiff_t>(removedLength);
+    // 旧Token中起点不早于旧编辑终点的，是可能的重新同步点
+    size_t candidate = firstTokenFrom(restartIndex, oldEditEnd);
+    
+    // 空位再移到重扫起点，其后直到末尾的源码连续存放；分析器绑定到这一段，
+    // 得到的偏移加上restartOffset。行首落在这一段之前，列号按无符号差计算，以回绕的偏移表示
+    source_.replace(offset, removedLength, insertedText);
+    source_.moveGap(restartOffset);
+    const std::string_view tail = source_.after();
+    RelexLexer lex{std::string_view{}};
+    lex.bindRange(tail, 0, restartLine, fromStart ? 0 : 0 - static_cast<size_t>(restartColumn - 1));
+    lex.deferOpenComment_ = true;
+    std::vector<Token> relexed;
+    bool synced = false;
+    int lineDelta = 0;
+    int columnDelta = 0;
+    int syncLine = 0;
+    int syncColumn = 0;
+    for(;;) {
+        Token token = lex.next().shifted(static_cast<std::ptrdiff_t>(restartOffset), 0, 0);
+        if(token.getType() == TokenType::EOF_TOKEN) {
+            relexed.push_back(token);
+            break;
+        }
+        if(token.getOffset() >= newEditEnd) {
+            size_t oldOffset = static_cast<size_t>(static_cast<std::ptrdiff_t>(token.getOffset()) - delta);
+            while(candidate < tokens_.size() && tokens_[candidate].getOffset() < oldOffset) {
+                candidate++;
+            }
+            const Token old = candidate < tokens_.size() ? tokens_[candidate] : token;
+            if(candidate < tokens_.size() && old.getOffset() == oldOffset &&
+               old.getType() != TokenType::EOF_TOKEN) {
+                // 同步点之后与旧结果一致，只需沿用旧Token；同步Token自身的错误（位置都在
+                // 其起点之后）属于保留部分
+                synced = true;
+                while(!lex.errors_.empty() &&
+                      positionAfter(lex.errors_.back().getLine(), lex.errors_.back().getColumn(),
+                                    token.getLine(), token.getColumn())) {
+                    lex.errors_.pop_back();
+                }
+                lineDelta = token.getLine() - old.getLine();
+                columnDelta = token.getColumn() - old.getColumn();
+                syncLine = old.getLine();
+                syncColumn = old.getColumn();
+                break;
+            }
+        }
+        relexed.push_back(token);
+    }
+    if(!synced) {
+        // 一直扫描到了末尾：restart之后的旧Token和错误全部作废
+        candidate = tokens_.size();
+    }
+    
+    // 错误：(restart, sync]之间的旧错误由重扫结果替代，其后的平移
+    std::vector<LexicalError> relexedErrors = shiftedBy(lex.errors_, restartOffset);
+    if(lex.commentOpen_) {
+        relexedErrors.emplace_back(ErrorCode::UNTERMINATED_COMMENT, lex.openCommentOffset_ + restartOffset, 0,
+                                   lex.openCommentLine_, lex.openCommentColumn_);
+    }
+    size_t errorsFirst = firstErrorAfter(restartLine, restartColumn);
+    size_t errorsLast = synced ? firstErrorAfter(syncLine, syncColumn) : errors_.size();
+    errors_.replace(errorsFirst, errorsLast, relexedErrors, synced ? delta : 0, lineDelta);
+    if(synced) {
+        errors_.shiftColumns(errorsFirst + relexedErrors.size(), syncLine + lineDelta, columnDelta);
+    }
+    
+    // 被替换的标识符释放引用。id超出Token表示范围的取不回名字（源码已改），只能整体重建
+    bool rebuild = false;
+    for(size_t k = restartIndex; k < candidate; ++k) {
+        Token replaced = tokens_[k];
+        if(replaced.getType() == TokenType::IDENTIFIER) {
+            int id = replaced.getSymbolId();
+            if(id >= 0) {
+                releaseSymbol(id);
+            } else {
+                rebuild = true;
+            }
+        }
+    }
+    if(!rebuild) {
+        for(auto& token : relexed) {
+            if(token.getType() == TokenType::IDENTIFIER) {
+                internToken(token, tail, restartOffset);
+            }
+        }
+    }
+    
+    // Token：替换[restart, candidate)，其后的只累加平移
+    tokens_.replace(restartIndex, candidate, relexed, synced ? delta : 0, lineDelta);
+    if(synced) {
+        tokens_.shiftColumns(restartIndex + relexed.size(), syncLine + lineDelta, columnDelta);
+    }
+    lastRelexed_ = relexed.size();
+    
+    size_t liveSymbols = symbols_.size() - deadSymbols_;
+    if(rebuild || deadSymbols_ > std::max(liveSymbols, tokens_.size() / 8)) {
+        rebuildSymbols();
+    }
+}
+
+std::string_view IncrementalLexer::getSource() {
+    return source_.view();
+}
+
+const std::vector<Token>& IncrementalLexer::getTokens() {
+    return tokens_.materialize();
+}
+
+const std::vector<LexicalError>& IncrementalLexer::getErrors() {
+    return errors_.materialize();
+}
+
+size_t IncrementalLexer::getTokenCount() const {
+    return tokens_.size();
+}
+
+Token IncrementalLexer::getToken(size_t index) const {
+    return tokens_[index];
+}
+
+size_t IncrementalLexer::getErrorCount() const {
+    return errors_.size();
+}
+
+LexicalError IncrementalLexer::getError(size_t index) const {
+    return errors_[index];
+}
+
+const SymbolTable& IncrementalLexer::getSymbolTable() const {
+    return symbols_;
+}
+
+size_t IncrementalLexer::getSymbolUses(int id) const {
+    return id >= 0 && static_cast<size_t>(id) < symbolUses_.size() ? symbolUses_[static_cast<size_t>(id)] : 0;
+}
+
+size_t IncrementalLexer::getLastRelexedCount() const {
+    return lastRelexed_;
+}
+
+}
@@ -0,0 +1,70 @@
+#ifndef INCREMENTAL_LEXER_H
+#define INCREMENTAL_LEXER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "gap_buffer.h"
+#include "lexer.h"
+
+namespace lexer {
+
+// 编辑器场景的增量词法分析：持有源码和上一次的Token流，每次编辑只从编辑点之前
+// 最近的完整Token开始重新扫描，直到新Token的起点与某个旧Token（平移后）重合，
+// 此后的旧Token和错误只平移位置。源码、Token和错误都存放在间隙缓冲中，空位留在上一次
+// 编辑处，同步点之后的平移只累加为一个待加的差值（同一行上的列号除外），因此一次编辑的
+// 代价与重扫的Token数、所在行的长度以及与上一次编辑的距离成正比，与文件长度无关。
+// 源码中不允许出现'\0'
+class IncrementalLexer {
+public:
+    explicit IncrementalLexer(std::string source);
+    
+    // 把[offset, offset + removedLength)替换为insertedText并更新Token流
+    void applyEdit(size_t offset, size_t removedLength, std::string_view insertedText);
+    
+    // 以下三者合上空位后返回连续的结果，代价与上一次编辑处之后的长度成正比，
+    // 结果在下一次编辑之前有效。只需局部结果时用getToken/getError逐个取出
+    std::string_view getSource();
+    // 标识符Token中的符号id与getSymbolTable()一致
+    const std::vector<Token>& getTokens();
+    const std::vector<LexicalError>& getErrors();
+    // 按下标取出，不合上空位
+    size_t getTokenCount() const;
+    Token getToken(size_t index) const;
+    size_t getErrorCount() const;
+    LexicalError getError(size_t index) const;
+    // 符号表随编辑维护：被替换的标识符减少引用计数，重扫出的标识符登记并增加计数，
+    // 代价与重扫的Token数成正比。符号id在编辑之间保持不变，新名字追加在末尾；不再出现的
+    // 名字以计数0暂留，这类条目多于存活的条目和Token数的1/8时，在编辑中按Token流压缩，
+    // 按首次出现顺序重新编号
+    const SymbolTable& getSymbolTable() const;
+    // 符号在Token流中出现的次数，0表示该名字已不再出现
+    size_t getSymbolUses(int id) const;
+    // 上一次编辑重新扫描得到的Token数，用于观察增量效果
+    size_t getLastRelexedCount() const;
+
+private:
+    GapString source_;
+    ShiftedGapVector<Token> tokens_;
+    // 按位置排列；“多行注释未闭合”位于注释起点，总是最后一项
+    ShiftedGapVector<LexicalError> errors_;
+    size_t lastRelexed_;
+    SymbolTable symbols_;
+    std::vector<std::uint32_t> symbolUses_;     // 下标为符号id
+    size_t deadSymbols_;                        // 计数为0的符号数
+    
+    // 第一个起点不早于offset的Token，从first开始查找
+    size_t firstTokenFrom(size_t first, size_t offset) const;
+    // 第一个位置在(line, column)之后的错误
+    size_t firstErrorAfter(int line, int column) const;
+    // 登记标识符Token的名字并填写其id，text为从base开始的一段源码
+    void internToken(Token& token, std::string_view text, size_t base);
+    void releaseSymbol(int id);
+    // 按Token流重新登记全部符号
+    void rebuildSymbols();
+};
+
+}
+
+#endif
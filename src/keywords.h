@@ -0,0 +1,97 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include "token_types.h"
+
+namespace lexer {
+
+namespace detail {
+
+struct KeywordEntry {
+    std::string_view text;
+    TokenType type;
+};
+
+constexpr KeywordEntry kKeywords[] = {
+    {"void", TokenType::VOID},     {"int", TokenType::INT},
+    {"float", TokenType::FLOAT},   {"double", TokenType::DOUBLE},
+    {"if", TokenType::IF},         {"else", TokenType::ELSE},
+    {"for", TokenType::FOR},       {"do", TokenType::DO},
+    {"while", TokenType::WHILE},   {"return", TokenType::RETURN},
+};
+
+constexpr size_t kKeywordSlots = 16;
+
+// 散列只取首字符、尾字符和长度：(首字符 × a + 尾字符 × b + 长度) mod 16
+struct KeywordHash {
+    unsigned a;
+    unsigned b;
+    
+    constexpr size_t operator()(std::string_view word) const {
+        return (static_cast<unsigned char>(word.front()) * a +
+                static_cast<unsigned char>(word.back()) * b +
+                static_cast<unsigned>(word.size())) % kKeywordSlots;
+    }
+};
+
+constexpr bool isPerfect(KeywordHash hash) {
+    bool used[kKeywordSlots] = {};
+    for(const auto& keyword : kKeywords) {
+        size_t slot = hash(keyword.text);
+        if(used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+// 编译期搜索使全部保留字互不冲突的系数
+constexpr KeywordHash findPerfectHash() {
+    for(unsigned a = 1; a < 64; ++a) {
+        for(unsigned b = 1; b < 64; ++b) {
+            if(isPerfect(KeywordHash{a, b})) {
+                return KeywordHash{a, b};
+            }
+        }
+    }
+    return KeywordHash{0, 0};
+}
+
+constexpr KeywordHash kKeywordHash = findPerfectHash();
+static_assert(kKeywordHash.a != 0, "找不到保留字的完美散列");
+
+constexpr std::array<KeywordEntry, kKeywordSlots> makeKeywordTable() {
+    std::array<KeywordEntry, kKeywordSlots> table{};
+    for(auto& entry : table) {
+        entry = KeywordEntry{std::string_view(), TokenType::IDENTIFIER};
+    }
+    for(const auto& keyword : kKeywords) {
+        table[kKeywordHash(keyword.text)] = keyword;
+    }
+    return table;
+}
+
+inline constexpr std::array<KeywordEntry, kKeywordSlots> kKeywordTable = makeKeywordTable();
+
+}
+
+// 保留字识别：一次散列加一次比较，直接作用于源码中的字节区间；
+// 不是保留字时返回IDENTIFIER
+constexpr TokenType classifyKeyword(std::string_view word) {
+    if(word.size() < 2 || word.size() > 6) {
+        return TokenType::IDENTIFIER;
+    }
+    const detail::KeywordEntry& entry = detail::kKeywordTable[detail::kKeywordHash(word)];
+    return entry.text == word ? entry.type : TokenType::IDENTIFIER;
+}
+
+static_assert(classifyKeyword("while") == TokenType::WHILE, "保留字散列表有误");
+static_assert(classifyKeyword("whale") == TokenType::IDENTIFIER, "保留字散列表有误");
+
+}
+
+#endif
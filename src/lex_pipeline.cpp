@@ -0,0 +1,197 @@
+#include "lex_pipeline.h"
+#include "output_writer.h"
+#include "spsc_ring.h"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <optional>
+#include <thread>
+
+namespace lexer {
+
+namespace {
+
+struct OutputChunk {
+    bool errors = false;        // 属于错误文件，否则属于Token文件
+    std::string text;
+};
+
+}
+
+LexPipeline::LexPipeline(const std::string& path)
+    : read_(StreamLexer::openInput(path)), errorLimit_(0), symbolRefs_(false), tokenCount_(0),
+      symbolCount_(0), errorCount_(0) {
+}
+
+void LexPipeline::setErrorLimit(size_t limit) {
+    errorLimit_ = limit;
+}
+
+void LexPipeline::setSymbolRefs(bool symbolRefs) {
+    symbolRefs_ = symbolRefs;
+}
+
+void LexPipeline::run(const std::string& tokensPath, const std::string& errorsPath,
+                      const std::string& symbolsPath) {
+    // 每对环中，一个把装满的块交给下游，另一个把用完的块还给上游
+    SpscRing<std::string, kRingSlots> inputFull;
+    SpscRing<std::string, kRingSlots> inputFree;
+    SpscRing<OutputChunk, kRingSlots> outputFull;
+    SpscRing<OutputChunk, kRingSlots> outputFree;
+    for(size_t i = 0; i < kRingSlots; ++i) {
+        inputFree.push(std::string());
+        outputFree.push(OutputChunk());
+    }
+    
+    // 分析在调用线程上进行：StreamLexer从输入环取块
+    std::string current;
+    bool holding = false;
+    size_t consumed = 0;
+    StreamLexer stream([&](char* data, size_t size) -> size_t {
+        while(!holding || consumed == current.size()) {
+            if(holding) {
+                inputFree.push(std::move(current));
+            }
+            consumed = 0;
+            holding = inputFull.pop(current);
+            if(!holding) {
+                current.clear();
+                return 0;
+            }
+        }
+        size_t n = std::min(size, current.size() - consumed);
+        std::memcpy(data, current.data() + consumed, n);
+        consumed += n;
+        return n;
+    });
+    stream.setErrorLimit(errorLimit_);
+    
+    std::exception_ptr readError;
+    std::exception_ptr lexError;
+    std::exception_ptr writeError;
+    
+    std::thread reader([&] {
+        try {
+            std::string chunk;
+            while(inputFree.pop(chunk)) {
+                chunk.resize(kReadChunk);
+                size_t n = read_(&chunk[0], kReadChunk);
+                if(n == 0) {
+                    break;
+                }
+                chunk.resize(n);
+                if(!inputFull.push(std::move(chunk))) {
+                    break;
+                }
+            }
+        } catch(...) {
+            readError = std::current_exception();
+        }
+        inputFull.close();
+    });
+    
+    std::thread writer([&] {
+        try {
+            std::optional<OutputWriter> tokensOut;
+            std::optional<OutputWriter> errorsOut;
+            if(!tokensPath.empty()) {
+                tokensOut.emplace(tokensPath);
+            }
+            if(!errorsPath.empty()) {
+                errorsOut.emplace(errorsPath);
+            }
+            OutputChunk chunk;
+            while(outputFull.pop(chunk)) {
+                (chunk.errors ? *errorsOut : *tokensOut).append(chunk.text);
+                chunk.text.clear();
+                outputFree.push(std::move(chunk));
+            }
+            if(tokensOut) {
+                tokensOut->close();
+            }
+            if(errorsOut) {
+                errorsOut->close();
+            }
+        } catch(...) {
+            writeError = std::current_exception();
+            // 让分析线程在下一次交付时停下
+            outputFull.close();
+            outputFree.close();
+        }
+    });
+    
+    // 每个窗口的文本先格式化进text，再与一个空块交换后交给写线程
+    std::string tokensText;
+    std::string errorsText;
+    {
+        OutputWriter tokensWriter(tokensText);
+        OutputWriter errorsWriter(errorsText);
+        auto deliver = [&](OutputWriter& writer, std::string& text, bool errors) {
+            writer.flush();
+            if(text.empty()) {
+                return true;
+            }
+            OutputChunk chunk;
+            if(!outputFree.pop(chunk)) {
+                return false;
+            }
+            chunk.errors = errors;
+            chunk.text.swap(text);
+            return outputFull.push(std::move(chunk));
+        };
+        try {
+            bool delivered = true;
+            while(delivered && stream.next()) {
+                if(!tokensPath.empty()) {
+                    stream.writeTokens(tokensWriter, symbolRefs_);
+                    delivered = deliver(tokensWriter, tokensText, false);
+                }
+                if(delivered && !errorsPath.empty()) {
+                    stream.writeErrors(errorsWriter);
+                    delivered = deliver(errorsWriter, errorsText, true);
+                }
+            }
+        } catch(...) {
+            lexError = std::current_exception();
+        }
+    }
+    
+    // 正常结束时读线程已退出；出错提前结束时关闭输入环让它停下
+    inputFull.close();
+    inputFree.close();
+    outputFull.close();
+    reader.join();
+    writer.join();
+    if(readError) {
+        std::rethrow_exception(readError);
+    }
+    if(lexError) {
+        std::rethrow_exception(lexError);
+    }
+    if(writeError) {
+        std::rethrow_exception(writeError);
+    }
+    
+    if(!symbolsPath.empty()) {
+        OutputWriter symbolsOut(symbolsPath);
+        stream.writeSymbolTable(symbolsOut);
+        symbolsOut.close();
+    }
+    tokenCount_ = stream.getTokenCount();
+    symbolCount_ = stream.getSymbolTable().size();
+    errorCount_ = stream.getErrorCount();
+}
+
+size_t LexPipeline::getTokenCount() const {
+    return tokenCount_;
+}
+
+size_t LexPipeline::getSymbolCount() const {
+    return symbolCount_;
+}
+
+size_t LexPipeline::getErrorCount() const {
+    return errorCount_;
+}
+
+}
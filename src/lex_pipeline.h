@@ -0,0 +1,44 @@
+#ifndef LEX_PIPELINE_H
+#define LEX_PIPELINE_H
+
+#include <string>
+#include "stream_lexer.h"
+
+namespace lexer {
+
+// 三段流水线的流式分析：读线程按块读入输入，分析线程（调用线程）在StreamLexer的窗口上扫描
+// 并把Token和错误格式化成文本块，写线程把文本块写入结果文件，I/O与分析相互重叠。
+// 阶段之间以SpscRing传递缓冲块，块在一对环之间循环复用：块都在下游时上游只能等待，
+// 内存占用固定。结果文件与顺序执行的--stream逐字节一致
+class LexPipeline {
+public:
+    // path为"-"时读取标准输入，打不开时抛出异常
+    explicit LexPipeline(const std::string& path);
+    
+    // 整个输入最多记录limit个错误（0表示不限）
+    void setErrorLimit(size_t limit);
+    // Token结果中的标识符写作符号id，见Lexer::writeTokens
+    void setSymbolRefs(bool symbolRefs);
+    // 分析整个输入并写出路径非空的结果文件；任一阶段出错时停止其余阶段并抛出该异常
+    void run(const std::string& tokensPath, const std::string& errorsPath,
+             const std::string& symbolsPath);
+    
+    size_t getTokenCount() const;
+    size_t getSymbolCount() const;
+    size_t getErrorCount() const;
+
+private:
+    static constexpr size_t kReadChunk = 256 * 1024;
+    static constexpr size_t kRingSlots = 8;
+    
+    StreamLexer::ReadFunction read_;
+    size_t errorLimit_;
+    bool symbolRefs_;
+    size_t tokenCount_;
+    size_t symbolCount_;
+    size_t errorCount_;
+};
+
+}
+
+#endif
@@ -1,17 +1,37 @@
 #include "lexer.h"
-#include <fstream>
-#include <sstream>
-#include <iomanip>
-#include <cctype>
+#include "char_class.h"
+#include "keywords.h"
+#include "output_writer.h"
+#include "simd_scan.h"
+#include "utf8.h"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
 
 namespace lexer {
 
-LexicalError::LexicalError(const std::string& message, int line, int column)
-    : message_(message), line_(line), column_(column) {
+namespace {
+
+// 连续非法字符的信息最多引用这么多字节，避免二进制文件产生超长的错误行
+constexpr size_t kRunPreview = 32;
+
+}
+
+LexicalError::LexicalError(ErrorCode code, size_t offset, size_t length, int line, int column)
+    : offset_(static_cast<std::uint32_t>(offset)), length_(static_cast<std::uint32_t>(length)),
+      line_(line), column_(column), code_(code) {
+}
+
+ErrorCode LexicalError::getCode() const {
+    return code_;
+}
+
+size_t LexicalError::getOffset() const {
+    return offset_;
 }
 
-std::string LexicalError::getMessage() const {
-    return message_;
+size_t LexicalError::getLength() const {
+    return length_;
 }
 
 int LexicalError::getLine() const {
@@ -22,45 +42,197 @@ int LexicalError::getColumn() const {
     return column_;
 }
 
-std::string LexicalError::toString() const {
-    std::ostringstream oss;
-    oss << "错误: [" << line_ << ":" << column_ << "] " << message_;
-    return oss.str();
+void LexicalError::appendMessage(OutputWriter& out, std::string_view source) const {
+    switch(code_) {
+    case ErrorCode::ILLEGAL_CHARACTER:
+        out.append("非法字符 '");
+        // 非ASCII字符每个码点单独报告，区间即一个完整的UTF-8编码
+        if(length_ == 1 || static_cast<unsigned char>(source[offset_]) >= 0x80) {
+            out.append(source.substr(offset_, length_));
+            out.append('\'');
+        } else {
+            out.append(source.substr(offset_, length_ < kRunPreview ? length_ : kRunPreview));
+            out.append(length_ > kRunPreview ? "...'（连续" : "'（连续");
+            out.appendInt(length_);
+            out.append("个）");
+        }
+        break;
+    case ErrorCode::IDENTIFIER_TOO_LONG:
+        out.append("标识符 '");
+        out.append(source.substr(offset_, length_));
+        out.append("' 长度超过32个字符");
+        break;
+    case ErrorCode::UNTERMINATED_COMMENT:
+        out.append("多行注释未闭合（从 ");
+        out.appendInt(line_);
+        out.append(':');
+        out.appendInt(column_);
+        out.append(" 开始）");
+        break;
+    case ErrorCode::INVALID_UTF8:
+        // 原样输出无效字节会使错误文件本身不再是合法的UTF-8，改为十六进制
+        out.append("无效的UTF-8编码");
+        for(size_t i = 0; i < length_; ++i) {
+            constexpr const char digits[] = "0123456789ABCDEF";
+            unsigned char byte = static_cast<unsigned char>(source[offset_ + i]);
+            out.append(" 0x");
+            out.append(digits[byte >> 4]);
+            out.append(digits[byte & 0xF]);
+        }
+        break;
+    }
 }
 
-Lexer::Lexer(const std::string& sourceCode)
-    : source_(sourceCode), pos_(0), line_(1), column_(1) {
-    currentChar_ = pos_ < source_.length() ? source_[pos_] : '\0';
-    initKeywords();
+void LexicalError::appendTo(OutputWriter& out, std::string_view source) const {
+    out.append("错误: [");
+    out.appendInt(line_);
+    out.append(':');
+    out.appendInt(column_);
+    out.append("] ");
+    appendMessage(out, source);
 }
 
-void Lexer::initKeywords() {
-    keywords_["void"] = TokenType::VOID;
-    keywords_["int"] = TokenType::INT;
-    keywords_["float"] = TokenType::FLOAT;
-    keywords_["double"] = TokenType::DOUBLE;
-    keywords_["if"] = TokenType::IF;
-    keywords_["else"] = TokenType::ELSE;
-    keywords_["for"] = TokenType::FOR;
-    keywords_["do"] = TokenType::DO;
-    keywords_["while"] = TokenType::WHILE;
-    keywords_["return"] = TokenType::RETURN;
+std::string LexicalError::getMessage(std::string_view source) const {
+    std::string message;
+    OutputWriter out(message);
+    appendMessage(out, source);
+    out.close();
+    return message;
+}
+
+std::string LexicalError::toString(std::string_view source) const {
+    std::string text;
+    OutputWriter out(text);
+    appendTo(out, source);
+    out.close();
+    return text;
+}
+
+LexicalError LexicalError::shifted(std::ptrdiff_t offsetDelta, int lineDelta, int columnDelta) const {
+    LexicalError result = *this;
+    result.offset_ = static_cast<std::uint32_t>(static_cast<std::ptrdiff_t>(offset_) + offsetDelta);
+    result.line_ += lineDelta;
+    result.column_ += columnDelta;
+    return result;
+}
+
+template <unsigned Features>
+BasicLexer<Features>::BasicLexer(const std::string& sourceCode)
+    : storage_(sourceCode), categoryCounts_{}, tokenCount_(0), errorCount_(0), errorLimit_(0),
+      indexOwner_(nullptr), lineIndexStale_(false) {
+    bind(storage_);
+}
+
+template <unsigned Features>
+BasicLexer<Features>::BasicLexer(std::string_view sourceView, std::pmr::memory_resource* resource)
+    : categoryCounts_{}, tokenCount_(0), errorCount_(0), errorLimit_(0), symbolTable_(resource),
+      indexOwner_(nullptr), lineIndexStale_(false) {
+    bind(sourceView);
+}
+
+template <unsigned Features>
+void BasicLexer<Features>::reset(std::string_view sourceView) {
+    storage_.clear();
+    if(tokens_.capacity() > kRetainedEntries) {
+        std::vector<Token>().swap(tokens_);
+    } else {
+        tokens_.clear();
+    }
+    categoryCounts_.fill(0);
+    tokenCount_ = 0;
+    if(errors_.capacity() > kRetainedEntries) {
+        std::vector<LexicalError>().swap(errors_);
+    } else {
+        errors_.clear();
+    }
+    errorCount_ = 0;
+    symbolTable_.clear();
+    lineIndexStale_ = lineIndex_ != nullptr;
+    bind(sourceView);
 }
 
-void Lexer::advance() {
+template <unsigned Features>
+void BasicLexer<Features>::bind(std::string_view source) {
+    // Token以32位记录偏移
+    if(source.length() > UINT32_MAX) {
+        throw std::length_error("源码超过4GiB，超出Token偏移范围");
+    }
+    // 原逐字符扫描在'\0'处停止，这里直接截断，之后的批量扫描只需检查边界
+    const void* nul = source.empty() ? nullptr : std::memchr(source.data(), '\0', source.length());
+    if(nul) {
+        source = source.substr(0, static_cast<const char*>(nul) - source.data());
+    }
+    bindRange(source, 0, 1, 0);
+}
+
+// 从begin（须位于Token边界且不在注释内）开始扫描，不再检查'\0'
+template <unsigned Features>
+void BasicLexer<Features>::bindRange(std::string_view source, size_t begin, int line, size_t lineStart) {
+    source_ = source;
+    pos_ = begin;
+    line_ = line;
+    lineStart_ = lineStart;
+    currentChar_ = pos_ < source_.length() ? source_[pos_] : '\0';
+    deferOpenComment_ = false;
+    commentOpen_ = false;
+    lineCommentOpen_ = false;
+    openCommentOffset_ = 0;
+    openCommentLine_ = 0;
+    openCommentColumn_ = 0;
+    errorCursor_.reset();
+}
+
+template <unsigned Features>
+void BasicLexer<Features>::advance() {
     if(pos_ < source_.length()) {
-        if(currentChar_ == '\n') {
+        if(kTracksPositions && currentChar_ == '\n') {
             line_++;
-            column_ = 1;
-        } else {
-            column_++;
+            lineStart_ = pos_ + 1;
         }
         pos_++;
         currentChar_ = pos_ < source_.length() ? source_[pos_] : '\0';
     }
 }
 
-char Lexer::peek(int offset) const {
+// 批量前进到target，区间内的换行一次性计入行号；不维护行号时不必数换行
+template <unsigned Features>
+void BasicLexer<Features>::advanceTo(size_t target) {
+    if constexpr(!kTracksPositions) {
+        advanceInLine(target);
+        return;
+    }
+    const char* data = source_.data();
+    simd::NewlineCount newlines = simd::countNewlines(data + pos_, data + target);
+    if(newlines.count > 0) {
+        line_ += static_cast<int>(newlines.count);
+        lineStart_ = static_cast<size_t>(newlines.last - data) + 1;
+    }
+    pos_ = target;
+    currentChar_ = pos_ < source_.length() ? source_[pos_] : '\0';
+}
+
+// 已知区间内没有换行时的批量前进
+template <unsigned Features>
+void BasicLexer<Features>::advanceInLine(size_t target) {
+    pos_ = target;
+    currentChar_ = pos_ < source_.length() ? source_[pos_] : '\0';
+}
+
+template <unsigned Features>
+int BasicLexer<Features>::column() const {
+    return static_cast<int>(pos_ - lineStart_) + 1;
+}
+
+template <unsigned Features>
+SourcePosition BasicLexer<Features>::tokenPosition() const {
+    if constexpr(kTracksPositions) {
+        return SourcePosition{line_, column()};
+    }
+    return SourcePosition{0, 0};
+}
+
+template <unsigned Features>
+char BasicLexer<Features>::peek(int offset) const {
     size_t peekPos = pos_ + offset;
     if (peekPos < source_.length()) {
         return source_[peekPos];
@@ -68,326 +240,500 @@ char Lexer::peek(int offset) const {
     return '\0';
 }
 
-void Lexer::error(const std::string& message) {
-    errors_.emplace_back(message, line_, column_);
+// 错误位于当前位置；offset和length指出信息引用的源码区间
+template <unsigned Features>
+void BasicLexer<Features>::error(ErrorCode code, size_t offset, size_t length) {
+    errorCount_++;
+    if constexpr(!kCollectsErrors) {
+        return;
+    }
+    if(errorLimit_ != 0 && errors_.size() >= errorLimit_) {
+        return;
+    }
+    if constexpr(kTracksPositions) {
+        errors_.emplace_back(code, offset, length, line_, column());
+    } else {
+        if(!errorCursor_) {
+            errorCursor_.emplace(getLineIndex());
+        }
+        SourcePosition position = errorCursor_->locate(pos_);
+        errors_.emplace_back(code, offset, length, position.line, position.column);
+    }
 }
 
-void Lexer::skipWhitespace() {
-    while(currentChar_ == ' ' || currentChar_ == '\t' || 
-          currentChar_ == '\n' || currentChar_ == '\r') {
-        advance();
+template <unsigned Features>
+void BasicLexer<Features>::skipWhitespace() {
+    // 常见的短空白（单个空格、换行加缩进）逐字节处理，超过kShortRun的长空白再交给SIMD
+    const size_t length = source_.length();
+    const size_t limit = pos_ + kShortRun < length ? pos_ + kShortRun : length;
+    while(pos_ < limit && classify(source_[pos_]) == CharClass::WHITESPACE) {
+        if(kTracksPositions && source_[pos_] == '\n') {
+            line_++;
+            lineStart_ = pos_ + 1;
+        }
+        pos_++;
+    }
+    if(pos_ == limit && limit < length) {
+        const char* data = source_.data();
+        size_t target = static_cast<size_t>(simd::skipWhitespace(data + pos_, data + length) - data);
+        advanceTo(target);
+        return;
     }
+    currentChar_ = pos_ < length ? source_[pos_] : '\0';
 }
 
-void Lexer::skipComment() {
+template <unsigned Features>
+void BasicLexer<Features>::skipComment() {
+    const char* data = source_.data();
+    const char* limit = data + source_.length();
     if(currentChar_ == '/' && peek() == '/') {
-        advance();
-        advance();
-        while(currentChar_ != '\0' && currentChar_ != '\n') {
-            advance();
-        }
+        // 停在换行符上，由skipWhitespace计入行号
+        const char* end = simd::findNewline(data + pos_ + 2, limit);
+        advanceInLine(static_cast<size_t>(end - data));
+        lineCommentOpen_ = end == limit && deferOpenComment_;
     } else if(currentChar_ == '/' && peek() == '*') {
+        size_t start = pos_;
         int startLine = line_;
-        int startColumn = column_;
-        advance();
-        advance();
+        int startColumn = column();
         
-        while(currentChar_ != '\0') {
-            if(currentChar_ == '*' && peek() == '/') {
-                advance();
-                advance();
-                return;
-            }
-            advance();
+        const char* close = simd::findCommentClose(data + pos_ + 2, limit);
+        advanceTo(close != limit ? static_cast<size_t>(close - data) + 2 : source_.length());
+        if(close != limit) {
+            return;
+        }
+        if constexpr(!kTracksPositions && kCollectsErrors) {
+            SourcePosition position = locate(start);
+            startLine = position.line;
+            startColumn = position.column;
         }
         
-        std::ostringstream oss;
-        oss << "多行注释未闭合（从 " << startLine << ":" << startColumn << " 开始）";
-        errors_.emplace_back(oss.str(), startLine, startColumn);
+        if(deferOpenComment_) {
+            commentOpen_ = true;
+            openCommentOffset_ = start;
+            openCommentLine_ = startLine;
+            openCommentColumn_ = startColumn;
+        } else {
+            reportUnterminatedComment(start, startLine, startColumn);
+        }
     }
 }
 
-Token Lexer::readIdentifier() {
-    int startLine = line_;
-    int startColumn = column_;
-    std::string identifier;
-    
-    while(std::isalnum(currentChar_) || currentChar_ == '_') {
-        identifier += currentChar_;
-        advance();
-    }
-    
-    if(identifier.length() > 32) {
-        std::ostringstream oss;
-        oss << "标识符 '" << identifier << "' 长度超过32个字符";
-        error(oss.str());
-        identifier = identifier.substr(0, 32);
-    }
-    
-    auto it = keywords_.find(identifier);
-    if(it != keywords_.end()) {
-        return Token(it->second, identifier, startLine, startColumn);
-    } else {
-        symbolTable_.insert(identifier);
-        return Token(TokenType::IDENTIFIER, identifier, startLine, startColumn);
+template <unsigned Features>
+void BasicLexer<Features>::reportUnterminatedComment(size_t offset, int line, int column) {
+    errorCount_++;
+    if(kCollectsErrors && (errorLimit_ == 0 || errors_.size() < errorLimit_)) {
+        errors_.emplace_back(ErrorCode::UNTERMINATED_COMMENT, offset, 0, line, column);
     }
 }
 
-Token Lexer::readNumber() {
-    int startLine = line_;
-    int startColumn = column_;
-    std::string number;
-    
-    while(std::isdigit(currentChar_)) {
-        number += currentChar_;
-        advance();
-    }
-    
-    return Token(TokenType::INTEGER, number, startLine, startColumn);
+template <unsigned Features>
+void BasicLexer<Features>::skipIdentChars() {
+    const size_t length = source_.length();
+    const size_t limit = pos_ + kShortRun < length ? pos_ + kShortRun : length;
+    size_t end = pos_;
+    while(end < limit && isIdentChar(source_[end])) {
+        end++;
+    }
+    if(end == limit && limit < length) {
+        const char* data = source_.data();
+        end = static_cast<size_t>(simd::skipIdentChars(data + end, data + length) - data);
+    }
+    advanceInLine(end);
 }
 
-Token Lexer::readOperator() {
-    int startLine = line_;
-    int startColumn = column_;
-    char current = currentChar_;
-    
-    if(current == '+') {
-        advance();
-        if(currentChar_ == '+') {
-            advance();
-            return Token(TokenType::INCREMENT, "++", startLine, startColumn);
-        } else if(currentChar_ == '=') {
-            advance();
-            return Token(TokenType::PLUS_ASSIGN, "+=", startLine, startColumn);
-        }
-        return Token(TokenType::PLUS, "+", startLine, startColumn);
-    }
-    
-    if(current == '-') {
-        advance();
-        if(currentChar_ == '-') {
-            advance();
-            return Token(TokenType::DECREMENT, "--", startLine, startColumn);
-        } else if(currentChar_ == '=') {
-            advance();
-            return Token(TokenType::MINUS_ASSIGN, "-=", startLine, startColumn);
-        }
-        return Token(TokenType::MINUS, "-", startLine, startColumn);
-    }
-    
-    if(current == '*') {
-        advance();
-        if(currentChar_ == '=') {
-            advance();
-            return Token(TokenType::MULTIPLY_ASSIGN, "*=", startLine, startColumn);
+// 连续的非ASCII字节先整段校验，合法部分按首字节得出编码长度，每个码点报一个非法字符；
+// 无效编码按最大无效子序列各报一个错误
+template <unsigned Features>
+void BasicLexer<Features>::skipNonAscii() {
+    const char* data = source_.data();
+    size_t end = pos_;
+    while(end < source_.length() && static_cast<unsigned char>(source_[end]) >= 0x80) {
+        end++;
+    }
+    while(pos_ < end) {
+        size_t invalid = static_cast<size_t>(simd::findInvalidUtf8(data + pos_, data + end) - data);
+        while(pos_ < invalid) {
+            size_t length = utf8::sequenceLength(static_cast<std::uint8_t>(currentChar_));
+            error(ErrorCode::ILLEGAL_CHARACTER, pos_, length);
+            advanceInLine(pos_ + length);
         }
-        return Token(TokenType::MULTIPLY, "*", startLine, startColumn);
-    }
-    
-    if(current == '/') {
-        advance();
-        if(currentChar_ == '=') {
-            advance();
-            return Token(TokenType::DIVIDE_ASSIGN, "/=", startLine, startColumn);
+        if(invalid < end) {
+            size_t length = utf8::decode(data + invalid, data + end).length;
+            error(ErrorCode::INVALID_UTF8, invalid, length);
+            advanceInLine(invalid + length);
         }
-        return Token(TokenType::DIVIDE, "/", startLine, startColumn);
     }
+}
+
+template <unsigned Features>
+Token BasicLexer<Features>::makeToken(TokenType type, size_t start, int line, int column) const {
+    return Token(type, start, pos_ - start, line, column);
+}
+
+template <unsigned Features>
+Token BasicLexer<Features>::readIdentifier() {
+    SourcePosition position = tokenPosition();
+    size_t start = pos_;
     
-    if(current == '=') {
-        advance();
-        if(currentChar_ == '=') {
-            advance();
-            return Token(TokenType::EQUAL, "==", startLine, startColumn);
-        }
-        return Token(TokenType::ASSIGN, "=", startLine, startColumn);
-    }
+    skipIdentChars();
     
-    if(current == '<') {
-        advance();
-        if(currentChar_ == '=') {
-            advance();
-            return Token(TokenType::LE, "<=", startLine, startColumn);
-        } else if(currentChar_ == '<') {
-            advance();
-            return Token(TokenType::LEFT_SHIFT, "<<", startLine, startColumn);
-        }
-        return Token(TokenType::LT, "<", startLine, startColumn);
+    std::string_view identifier = source_.substr(start, pos_ - start);
+    if(identifier.length() > 32) {
+        error(ErrorCode::IDENTIFIER_TOO_LONG, start, identifier.length());
+        identifier = identifier.substr(0, 32);
     }
     
-    if(current == '>') {
-        advance();
-        if(currentChar_ == '=') {
-            advance();
-            return Token(TokenType::GE, ">=", startLine, startColumn);
-        } else if(currentChar_ == '>') {
-            advance();
-            return Token(TokenType::RIGHT_SHIFT, ">>", startLine, startColumn);
+    TokenType type = classifyKeyword(identifier);
+    if(type == TokenType::IDENTIFIER) {
+        int symbolId = -1;
+        if constexpr(kInternsSymbols) {
+            symbolId = symbolTable_.insert(identifier);
         }
-        return Token(TokenType::GT, ">", startLine, startColumn);
+        return Token::identifier(start, symbolId, position.line, position.column);
     }
+    return Token(type, start, identifier.length(), position.line, position.column);
+}
+
+template <unsigned Features>
+Token BasicLexer<Features>::readNumber() {
+    SourcePosition position = tokenPosition();
+    size_t start = pos_;
     
-    if(current == '!') {
+    while(isDigitChar(currentChar_)) {
         advance();
-        if(currentChar_ == '=') {
-            advance();
-            return Token(TokenType::NOT_EQUAL, "!=", startLine, startColumn);
-        }
-        return Token(TokenType::NOT, "!", startLine, startColumn);
     }
     
-    if(current == '&') {
-        advance();
-        if(currentChar_ == '&') {
-            advance();
-            return Token(TokenType::AND, "&&", startLine, startColumn);
-        }
-        std::ostringstream oss;
-        oss << "非法字符 '&'";
-        error(oss.str());
-        return Token(TokenType::ERROR, "&", startLine, startColumn);
-    }
+    return makeToken(TokenType::INTEGER, start, position.line, position.column);
+}
+
+template <unsigned Features>
+Token BasicLexer<Features>::readOperator() {
+    SourcePosition position = tokenPosition();
+    size_t start = pos_;
+    char current = currentChar_;
     
-    if(current == '|') {
+    advance();
+    TokenType pair = operatorPair(current, currentChar_);
+    if(pair != TokenType::ERROR) {
         advance();
-        if(currentChar_ == '|') {
-            advance();
-            return Token(TokenType::OR, "||", startLine, startColumn);
-        }
-        std::ostringstream oss;
-        oss << "非法字符 '|'";
-        error(oss.str());
-        return Token(TokenType::ERROR, "|", startLine, startColumn);
+        return makeToken(pair, start, position.line, position.column);
     }
     
-    if(current == ';') {
-        advance();
-        return Token(TokenType::SEMICOLON, ";", startLine, startColumn);
-    }
-    if(current == ',') {
-        advance();
-        return Token(TokenType::COMMA, ",", startLine, startColumn);
-    }
-    if(current == '(') {
-        advance();
-        return Token(TokenType::LPAREN, "(", startLine, startColumn);
-    }
-    if(current == ')') {
-        advance();
-        return Token(TokenType::RPAREN, ")", startLine, startColumn);
+    TokenType single = kSingleOperator[static_cast<unsigned char>(current)];
+    if(single == TokenType::ERROR) {
+        error(ErrorCode::ILLEGAL_CHARACTER, start, 1);
     }
-    if(current == '{') {
-        advance();
-        return Token(TokenType::LBRACE, "{", startLine, startColumn);
-    }
-    if(current == '}') {
-        advance();
-        return Token(TokenType::RBRACE, "}", startLine, startColumn);
-    }
-    
-    std::ostringstream oss;
-    oss << "非法字符 '" << current << "'";
-    error(oss.str());
-    advance();
-    return Token(TokenType::ERROR, std::string(1, current), startLine, startColumn);
+    return makeToken(single, start, position.line, position.column);
 }
 
-std::vector<Token> Lexer::tokenize() {
-    tokens_.clear();
-    
-    while(currentChar_ != '\0') {
-        if(currentChar_ == ' ' || currentChar_ == '\t' || 
-           currentChar_ == '\n' || currentChar_ == '\r') {
+template <unsigned Features>
+Token BasicLexer<Features>::next() {
+    for(;;) {
+        switch(classify(currentChar_)) {
+        case CharClass::END: {
+            SourcePosition position = tokenPosition();
+            return makeToken(TokenType::EOF_TOKEN, pos_, position.line, position.column);
+        }
+        case CharClass::WHITESPACE:
             skipWhitespace();
             continue;
+        case CharClass::SLASH:
+            if(peek() == '/' || peek() == '*') {
+                skipComment();
+                continue;
+            }
+            return readOperator();
+        case CharClass::IDENT_START:
+            return readIdentifier();
+        case CharClass::DIGIT:
+            return readNumber();
+        case CharClass::OPERATOR:
+            return readOperator();
+        case CharClass::ILLEGAL:
+            break;
         }
         
-        if(currentChar_ == '/' && (peek() == '/' || peek() == '*')) {
-            skipComment();
+        if(static_cast<unsigned char>(currentChar_) >= 0x80) {
+            skipNonAscii();
             continue;
         }
-        
-        if(std::isalpha(currentChar_) || currentChar_ == '_') {
-            tokens_.push_back(readIdentifier());
-            continue;
+        // 相邻的ASCII非法字符合并为一个错误（非法字符都不是换行，可直接前进）
+        size_t end = pos_ + 1;
+        while(end < source_.length() && classify(source_[end]) == CharClass::ILLEGAL &&
+              static_cast<unsigned char>(source_[end]) < 0x80) {
+            end++;
         }
-        
-        if(std::isdigit(currentChar_)) {
-            tokens_.push_back(readNumber());
-            continue;
+        error(ErrorCode::ILLEGAL_CHARACTER, pos_, end - pos_);
+        advanceInLine(end);
+    }
+}
+
+template <unsigned Features>
+size_t BasicLexer<Features>::next(Token* tokens, size_t capacity) {
+    size_t count = 0;
+    while(count < capacity) {
+        tokens[count] = next();
+        if(tokens[count++].getType() == TokenType::EOF_TOKEN) {
+            break;
         }
+    }
+    return count;
+}
+
+template <unsigned Features>
+typename BasicLexer<Features>::iterator BasicLexer<Features>::begin() {
+    return iterator(this);
+}
+
+template <unsigned Features>
+typename BasicLexer<Features>::iterator BasicLexer<Features>::end() {
+    return iterator();
+}
+
+template <unsigned Features>
+const std::vector<Token>& BasicLexer<Features>::tokenize() {
+    if constexpr(kKeepsTokens) {
+        tokens_.clear();
+        // 按典型代码每8字节约一个Token预留，避免大文件反复扩容搬移
+        tokens_.reserve((source_.length() - pos_) / 8 + 1);
         
-        if(currentChar_ == '+' || currentChar_ == '-' || currentChar_ == '*' || 
-           currentChar_ == '/' || currentChar_ == '=' || currentChar_ == '<' || 
-           currentChar_ == '>' || currentChar_ == '!' || currentChar_ == '&' || 
-           currentChar_ == '|' || currentChar_ == ';' || currentChar_ == ',' || 
-           currentChar_ == '(' || currentChar_ == ')' || currentChar_ == '{' || 
-           currentChar_ == '}') {
-            tokens_.push_back(readOperator());
-            continue;
+        for(const Token& token : *this) {
+            tokens_.push_back(token);
+        }
+    } else {
+        for(const Token& token : *this) {
+            categoryCounts_[static_cast<size_t>(token.getCategoryCode() + 1)]++;
+            tokenCount_++;
         }
-        
-        std::ostringstream oss;
-        oss << "非法字符 '" << currentChar_ << "'";
-        error(oss.str());
-        advance();
     }
-    
-    tokens_.push_back(Token(TokenType::EOF_TOKEN, "", line_, column_));
     return tokens_;
 }
 
-bool Lexer::hasErrors() const {
-    return !errors_.empty();
+template <unsigned Features>
+const std::vector<Token>& BasicLexer<Features>::getTokens() const {
+    return tokens_;
+}
+
+template <unsigned Features>
+size_t BasicLexer<Features>::getTokenCount() const {
+    return kKeepsTokens ? tokens_.size() : tokenCount_;
 }
 
-const std::vector<LexicalError>& Lexer::getErrors() const {
+template <unsigned Features>
+std::array<std::uint64_t, kCategorySlots> BasicLexer<Features>::getCategoryCounts() const {
+    if constexpr(kKeepsTokens) {
+        std::array<std::uint64_t, kCategorySlots> counts{};
+        for(const auto& token : tokens_) {
+            counts[static_cast<size_t>(token.getCategoryCode() + 1)]++;
+        }
+        return counts;
+    }
+    return categoryCounts_;
+}
+
+template <unsigned Features>
+BasicLexer<Features>::iterator::iterator()
+    : lexer_(nullptr), current_(TokenType::EOF_TOKEN, 0, 0, 0, 0) {
+}
+
+template <unsigned Features>
+BasicLexer<Features>::iterator::iterator(BasicLexer* lexer)
+    : lexer_(lexer), current_(lexer->next()) {
+}
+
+template <unsigned Features>
+typename BasicLexer<Features>::iterator::reference BasicLexer<Features>::iterator::operator*() const {
+    return current_;
+}
+
+template <unsigned Features>
+typename BasicLexer<Features>::iterator::pointer BasicLexer<Features>::iterator::operator->() const {
+    return &current_;
+}
+
+template <unsigned Features>
+typename BasicLexer<Features>::iterator& BasicLexer<Features>::iterator::operator++() {
+    if(current_.getType() == TokenType::EOF_TOKEN) {
+        lexer_ = nullptr;
+    } else {
+        current_ = lexer_->next();
+    }
+    return *this;
+}
+
+template <unsigned Features>
+bool BasicLexer<Features>::iterator::operator==(const iterator& other) const {
+    return lexer_ == other.lexer_;
+}
+
+template <unsigned Features>
+bool BasicLexer<Features>::iterator::operator!=(const iterator& other) const {
+    return !(*this == other);
+}
+
+template <unsigned Features>
+bool BasicLexer<Features>::hasErrors() const {
+    return errorCount_ > 0;
+}
+
+template <unsigned Features>
+const std::vector<LexicalError>& BasicLexer<Features>::getErrors() const {
     return errors_;
 }
 
-const SymbolTable& Lexer::getSymbolTable() const {
+template <unsigned Features>
+size_t BasicLexer<Features>::getErrorCount() const {
+    return errorCount_;
+}
+
+template <unsigned Features>
+void BasicLexer<Features>::setErrorLimit(size_t limit) {
+    errorLimit_ = limit;
+}
+
+// 分块扫描时多个块可能同时首次需要索引，故加锁
+template <unsigned Features>
+const LineIndex& BasicLexer<Features>::getLineIndex() const {
+    const BasicLexer& owner = indexOwner_ ? *indexOwner_ : *this;
+    std::lock_guard<std::mutex> lock(owner.lineIndexMutex_);
+    if(!owner.lineIndex_) {
+        owner.lineIndex_ = std::make_unique<LineIndex>(owner.source_);
+    } else if(owner.lineIndexStale_) {
+        owner.lineIndex_->assign(owner.source_);
+    }
+    owner.lineIndexStale_ = false;
+    return *owner.lineIndex_;
+}
+
+template <unsigned Features>
+SourcePosition BasicLexer<Features>::locate(size_t offset) const {
+    return getLineIndex().locate(offset);
+}
+
+template <unsigned Features>
+const SymbolTable& BasicLexer<Features>::getSymbolTable() const {
     return symbolTable_;
 }
 
-void Lexer::writeTokens(const std::string& filepath) const {
-    std::ofstream outFile(filepath);
-    if(!outFile) {
-        throw std::runtime_error("无法创建文件: " + filepath);
+template <unsigned Features>
+int BasicLexer<Features>::symbolId(const Token& token) const {
+    if constexpr(!kInternsSymbols) {
+        return -1;
+    }
+    int id = token.getSymbolId();
+    if(id < 0 && token.getType() == TokenType::IDENTIFIER) {
+        const SymbolInfo* symbol = symbolTable_.lookup(token.getValue(source_));
+        id = symbol ? symbol->id : -1;
+    }
+    return id;
+}
+
+template <unsigned Features>
+std::string_view BasicLexer<Features>::getSource() const {
+    return source_;
+}
+
+template <unsigned Features>
+void BasicLexer<Features>::writeTokens(const std::string& filepath, bool symbolRefs) const {
+    OutputWriter out(filepath);
+    writeTokens(out, symbolRefs);
+    out.close();
+}
+
+template <unsigned Features>
+void BasicLexer<Features>::writeSymbolTable(const std::string& filepath) const {
+    OutputWriter out(filepath);
+    writeSymbolTable(out);
+    out.close();
+}
+
+template <unsigned Features>
+void BasicLexer<Features>::writeErrors(const std::string& filepath) const {
+    OutputWriter out(filepath);
+    writeErrors(out);
+    out.close();
+}
+
+template <unsigned Features>
+void BasicLexer<Features>::writeTokens(OutputWriter& out, bool symbolRefs) const {
+    if constexpr(!kKeepsTokens) {
+        throw std::logic_error("该Lexer实例不保留Token，无法输出Token序列");
+    }
+    if constexpr(!kInternsSymbols) {
+        if(symbolRefs) {
+            throw std::logic_error("该Lexer实例不登记符号，无法以符号id输出标识符");
+        }
     }
     for(const auto& token : tokens_) {
-        outFile << "(" << token.getCategoryCode() << ", " << token.getValue() << ")\n";
+        out.append('(');
+        out.appendInt(token.getCategoryCode());
+        out.append(", ");
+        if(symbolRefs && token.getType() == TokenType::IDENTIFIER) {
+            out.append('#');
+            out.appendInt(symbolId(token));
+        } else {
+            out.append(token.getValue(source_));
+        }
+        out.append(")\n");
     }
 }
 
-void Lexer::writeSymbolTable(const std::string& filepath) const {
-    std::ofstream outFile(filepath);
-    if(!outFile) {
-        throw std::runtime_error("无法创建文件: " + filepath);
+template <unsigned Features>
+void BasicLexer<Features>::writeSymbolTable(OutputWriter& out) const {
+    if constexpr(!kInternsSymbols) {
+        throw std::logic_error("该Lexer实例不登记符号，无法输出符号表");
     }
-    auto symbols = symbolTable_.getAllSymbols();
+    const auto& symbols = symbolTable_.getAllSymbols();
     if(symbols.empty()) {
-        outFile << "符号表为空\n";
+        out.append("符号表为空\n");
         return;
     }
-    outFile << "ID  | 标识符名\n";
-    outFile << "----|----------\n";
+    out.append("ID  | 标识符名\n");
+    out.append("----|----------\n");
     for(const auto& symbol : symbols) {
-        outFile << std::left << std::setw(4) << symbol.id << "| " << symbol.name << "\n";
+        out.appendIntPadded(symbol.id, 4);
+        out.append("| ");
+        out.append(symbol.name);
+        out.append('\n');
     }
 }
 
-void Lexer::writeErrors(const std::string& filepath) const {
-    std::ofstream outFile(filepath);
-    if(!outFile) {
-        throw std::runtime_error("无法创建文件: " + filepath);
+template <unsigned Features>
+void BasicLexer<Features>::writeErrors(OutputWriter& out) const {
+    if constexpr(!kCollectsErrors) {
+        throw std::logic_error("该Lexer实例不记录错误，无法输出错误列表");
     }
-    
     if(errors_.empty()) {
-        outFile << "无错误\n";
-    } else {
-        for(const auto& error : errors_) {
-            outFile << error.toString() << "\n";
-        }
+        out.append("无错误\n");
+        return;
+    }
+    for(const auto& error : errors_) {
+        error.appendTo(out, source_);
+        out.append('\n');
+    }
+    if(errorCount_ > errors_.size()) {
+        out.append("另有 ");
+        out.appendInt(static_cast<long long>(errorCount_ - errors_.size()));
+        out.append(" 个错误超出记录上限，未列出\n");
     }
 }
 
+// 全部16种功能组合
+template class BasicLexer<0>;
+template class BasicLexer<1>;
+template class BasicLexer<2>;
+template class BasicLexer<3>;
+template class BasicLexer<4>;
+template class BasicLexer<5>;
+template class BasicLexer<6>;
+template class BasicLexer<7>;
+template class BasicLexer<8>;
+template class BasicLexer<9>;
+template class BasicLexer<10>;
+template class BasicLexer<11>;
+template class BasicLexer<12>;
+template class BasicLexer<13>;
+template class BasicLexer<14>;
+template class BasicLexer<15>;
+
 } // namespace lexer
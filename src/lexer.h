@@ -1,63 +1,211 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
+#include "lexer_features.h"
+#include "line_index.h"
 #include "token_types.h"
 #include "symbol_table.h"
 
 namespace lexer {
 
+class IncrementalLexer;
+class OutputWriter;
+class ParallelLexer;
+class StatsCollector;
+class StreamLexer;
+
+enum class ErrorCode : std::uint8_t {
+    ILLEGAL_CHARACTER,          // 参数：连续非法字符的区间
+    IDENTIFIER_TOO_LONG,        // 参数：整个标识符的区间
+    UNTERMINATED_COMMENT,       // 参数：注释起点
+    INVALID_UTF8                // 参数：一个无效UTF-8编码（最大无效子序列）的区间
+};
+
+// 紧凑的错误记录：只存错误码、源码区间和位置，信息在输出时才按源码格式化
 class LexicalError {
 public:
-    LexicalError(const std::string& message, int line, int column);
+    LexicalError(ErrorCode code, size_t offset, size_t length, int line, int column);
     
-    std::string getMessage() const;
+    ErrorCode getCode() const;
+    size_t getOffset() const;
+    size_t getLength() const;
     int getLine() const;
     int getColumn() const;
-    std::string toString() const;
-    
+    // source须是产生该错误的源码
+    std::string getMessage(std::string_view source) const;
+    std::string toString(std::string_view source) const;
+    void appendMessage(OutputWriter& out, std::string_view source) const;
+    void appendTo(OutputWriter& out, std::string_view source) const;
+    // 源码编辑后平移位置，供增量分析沿用旧错误
+    LexicalError shifted(std::ptrdiff_t offsetDelta, int lineDelta, int columnDelta) const;
+
 private:
-    std::string message_;
+    std::uint32_t offset_;
+    std::uint32_t length_;
     int line_;
     int column_;
+    ErrorCode code_;
 };
 
-class Lexer {
+// 词法分析器，Features为LexerFeature的组合（见lexer_features.h），Lexer即全部功能的实例。
+// 各实例在lexer.cpp中显式实例化
+template <unsigned Features>
+class BasicLexer {
 public:
-    explicit Lexer(const std::string& sourceCode);
+    static constexpr bool kTracksPositions = (Features & kTrackPositions) != 0;
+    static constexpr bool kInternsSymbols = (Features & kInternSymbols) != 0;
+    static constexpr bool kCollectsErrors = (Features & kCollectErrors) != 0;
+    static constexpr bool kKeepsTokens = (Features & kKeepTokens) != 0;
+    
+    // 单遍输入迭代器：每次递增按需扫描下一个Token，最后一个元素为EOF
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Token;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Token*;
+        using reference = const Token&;
+        
+        iterator();
+        explicit iterator(BasicLexer* lexer);
+        
+        reference operator*() const;
+        pointer operator->() const;
+        iterator& operator++();
+        bool operator==(const iterator& other) const;
+        bool operator!=(const iterator& other) const;
+    
+    private:
+        BasicLexer* lexer_;
+        Token current_;
+    };
+    
+    explicit BasicLexer(const std::string& sourceCode);
+    // 不拷贝源码，直接在调用方的缓冲区（如mmap映射）上扫描，缓冲区须比Lexer存活更久。
+    // resource提供符号表名字所用的内存块
+    explicit BasicLexer(std::string_view sourceView,
+                        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    // source_可能指向storage_，禁止拷贝以免悬空
+    BasicLexer(const BasicLexer&) = delete;
+    BasicLexer& operator=(const BasicLexer&) = delete;
+    
+    // 改为从头分析sourceView（同样不拷贝），清空上一次的结果但保留Token/错误列表、
+    // 符号表索引和内存块的容量，供批处理和守护进程在大量文件间复用同一个Lexer。
+    // 错误上限保持不变
+    void reset(std::string_view sourceView);
     
-    std::vector<Token> tokenize();
+    // 流式接口：扫描并返回下一个Token，到达末尾后始终返回EOF
+    Token next();
+    // 成批扫描：写入至多capacity个Token并返回个数，写入EOF后即停止，供C接口等按批取用的调用方
+    size_t next(Token* tokens, size_t capacity);
+    iterator begin();
+    iterator end();
+    
+    // 批量接口：在next()之上扫描剩余Token。保留Token的实例把它们物化到内部列表供write*使用，
+    // 其余实例只按类别计数（返回的列表为空）
+    const std::vector<Token>& tokenize();
+    const std::vector<Token>& getTokens() const;
+    // tokenize()得到的Token总数（含EOF）及各类别的个数，下标为类别码加1
+    size_t getTokenCount() const;
+    std::array<std::uint64_t, kCategorySlots> getCategoryCounts() const;
     bool hasErrors() const;
+    // 只包含记录下来的错误；超过上限的、以及不记录错误的实例中的错误只计数
     const std::vector<LexicalError>& getErrors() const;
+    size_t getErrorCount() const;
+    // 每个文件最多记录limit个错误（0表示不限），须在扫描开始前设置
+    void setErrorLimit(size_t limit);
+    // 不登记符号的实例中始终为空
     const SymbolTable& getSymbolTable() const;
+    // 标识符Token在符号表中的id：取Token中记录的id，没有时按名字查找；
+    // 不是标识符或不登记符号的实例中为-1
+    int symbolId(const Token& token) const;
+    std::string_view getSource() const;
+    
+    // 不维护行号的实例中Token的行列号为0，需要时用locate()按偏移换算；错误仍带有正确的行列号。
+    // 首次调用时一遍扫描建立换行索引
+    const LineIndex& getLineIndex() const;
+    SourcePosition locate(size_t offset) const;
     
-    void writeTokens(const std::string& filepath) const;
+    // symbolRefs为true时标识符写作(21, #符号id)，id与符号表文件中的编号对应
+    void writeTokens(const std::string& filepath, bool symbolRefs = false) const;
     void writeSymbolTable(const std::string& filepath) const;
     void writeErrors(const std::string& filepath) const;
-    
+    // 写入已有的写入器（文件或内存），不关闭它。实例缺少所需功能时抛出std::logic_error
+    void writeTokens(OutputWriter& out, bool symbolRefs = false) const;
+    void writeSymbolTable(OutputWriter& out) const;
+    void writeErrors(OutputWriter& out) const;
+
 private:
-    std::string source_;
+    friend class IncrementalLexer;
+    friend class ParallelLexer;
+    friend class StreamLexer;
+    
+    // 短于此长度的空白和标识符直接逐字节扫描，省去SIMD调用开销
+    static constexpr size_t kShortRun = 16;
+    // reset()时容量超过此数的Token或错误列表不再保留，免得一个大文件之后长期占用内存
+    static constexpr size_t kRetainedEntries = 1 << 20;
+    
+    std::string storage_;
+    std::string_view source_;
     size_t pos_;
     int line_;
-    int column_;
+    size_t lineStart_;      // 当前行首的偏移，列号由pos_ - lineStart_得出
     char currentChar_;
     
     std::vector<Token> tokens_;
+    // 不保留Token的实例在tokenize()中计数
+    std::array<std::uint64_t, kCategorySlots> categoryCounts_;
+    size_t tokenCount_;
     std::vector<LexicalError> errors_;
+    size_t errorCount_;
+    size_t errorLimit_;
     SymbolTable symbolTable_;
-    std::unordered_map<std::string, TokenType> keywords_;
     
+    // 分块扫描时，到块末尾仍未闭合的多行注释不立即报错，而是记下起点交给拼接方处理
+    bool deferOpenComment_;
+    bool commentOpen_;
+    bool lineCommentOpen_;  // 单行注释一直延续到块末尾（块在行中间切开时）
+    size_t openCommentOffset_;
+    int openCommentLine_;
+    int openCommentColumn_;
+    
+    // 分块扫描的各块共用拼接方的换行索引；为空表示使用自己的
+    const BasicLexer* indexOwner_;
+    mutable std::mutex lineIndexMutex_;
+    mutable std::unique_ptr<LineIndex> lineIndex_;
+    mutable bool lineIndexStale_;       // lineIndex_属于reset()之前的源码
+    std::optional<LineIndex::Cursor> errorCursor_;     // 错误按偏移递增产生，顺序换算
+    
+    void bind(std::string_view source);
+    void bindRange(std::string_view source, size_t begin, int line, size_t lineStart);
     void advance();
+    void advanceTo(size_t target);
+    void advanceInLine(size_t target);
+    int column() const;
+    // 当前位置作为Token起点时记录的行列号
+    SourcePosition tokenPosition() const;
     char peek(int offset = 1) const;
-    void error(const std::string& message);
+    void error(ErrorCode code, size_t offset, size_t length);
     void skipWhitespace();
     void skipComment();
+    void reportUnterminatedComment(size_t offset, int line, int column);
+    void skipIdentChars();
+    void skipNonAscii();
+    Token makeToken(TokenType type, size_t start, int line, int column) const;
     Token readIdentifier();
     Token readNumber();
     Token readOperator();
-    void initKeywords();
 };
 
 } // namespace lexer
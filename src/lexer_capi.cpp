@@ -0,0 +1,228 @@
+#include "lexer_capi.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "lexer.h"
+
+static_assert(LEXER_TRACK_POSITIONS == lexer::kTrackPositions && LEXER_INTERN_SYMBOLS == lexer::kInternSymbols &&
+              LEXER_COLLECT_ERRORS == lexer::kCollectErrors, "C接口的功能位须与LexerFeature一致");
+
+namespace lexer {
+
+namespace {
+
+// 按创建时的功能选出的BasicLexer实例。Token直接交给调用方，各实例都不保存Token
+class SessionLexer {
+public:
+    virtual ~SessionLexer() = default;
+    virtual void setErrorLimit(size_t limit) = 0;
+    virtual void reset(std::string_view source) = 0;
+    virtual size_t next(Token* tokens, size_t capacity) = 0;
+    virtual std::string_view getSource() const = 0;
+    virtual const SymbolTable& getSymbolTable() const = 0;
+    virtual int symbolId(const Token& token) const = 0;
+    virtual const std::vector<LexicalError>& getErrors() const = 0;
+    virtual size_t getErrorCount() const = 0;
+};
+
+template <unsigned Features>
+class SessionLexerImpl : public SessionLexer {
+public:
+    SessionLexerImpl() : lexer_(std::string_view()) {
+    }
+    
+    void setErrorLimit(size_t limit) override {
+        lexer_.setErrorLimit(limit);
+    }
+    
+    void reset(std::string_view source) override {
+        lexer_.reset(source);
+    }
+    
+    size_t next(Token* tokens, size_t capacity) override {
+        return lexer_.next(tokens, capacity);
+    }
+    
+    std::string_view getSource() const override {
+        return lexer_.getSource();
+    }
+    
+    const SymbolTable& getSymbolTable() const override {
+        return lexer_.getSymbolTable();
+    }
+    
+    int symbolId(const Token& token) const override {
+        return lexer_.symbolId(token);
+    }
+    
+    const std::vector<LexicalError>& getErrors() const override {
+        return lexer_.getErrors();
+    }
+    
+    size_t getErrorCount() const override {
+        return lexer_.getErrorCount();
+    }
+
+private:
+    BasicLexer<Features> lexer_;
+};
+
+// 每批先扫描进会话内的Token数组再转换，调用方的数组再大也不需要同样大的中转空间
+constexpr size_t kBatchTokens = 1024;
+
+// 在catch块内调用，把正在处理的异常换算成返回码；异常不能越过extern "C"的边界
+int currentErrorCode() {
+    try {
+        throw;
+    } catch(const std::bad_alloc&) {
+        return LEXER_OUT_OF_MEMORY;
+    } catch(const std::length_error&) {
+        return LEXER_SOURCE_TOO_LARGE;
+    } catch(...) {
+        return LEXER_INTERNAL_ERROR;
+    }
+}
+
+}
+
+}
+
+struct lexer_session {
+    std::unique_ptr<lexer::SessionLexer> lexer;
+    std::vector<lexer::Token> batch;
+    bool finished = true;       // 已交出EOF，或尚未绑定源码
+};
+
+int lexer_capi_version(void) {
+    return LEXER_CAPI_VERSION;
+}
+
+lexer_session* lexer_create(unsigned features) {
+    try {
+        auto session = std::make_unique<lexer_session>();
+        session->lexer = lexer::withLexerFeatures(features & LEXER_ALL_FEATURES, [](auto variant) {
+            return std::unique_ptr<lexer::SessionLexer>(
+                std::make_unique<lexer::SessionLexerImpl<decltype(variant)::value & ~lexer::kKeepTokens>>());
+        });
+        session->batch.assign(lexer::kBatchTokens, lexer::Token(lexer::TokenType::EOF_TOKEN, 0, 0, 0, 0));
+        return session.release();
+    } catch(...) {
+        return nullptr;
+    }
+}
+
+void lexer_destroy(lexer_session* session) {
+    delete session;
+}
+
+void lexer_set_error_limit(lexer_session* session, size_t limit) {
+    session->lexer->setErrorLimit(limit);
+}
+
+int lexer_reset(lexer_session* session, const char* source, size_t length) {
+    session->finished = true;
+    try {
+        session->lexer->reset(std::string_view(source, source ? length : 0));
+    } catch(...) {
+        return lexer::currentErrorCode();
+    }
+    session->finished = false;
+    return LEXER_OK;
+}
+
+int lexer_next_tokens(lexer_session* session, lexer_token* tokens, size_t capacity, size_t* count) {
+    return lexer_next_tokens_with_symbols(session, tokens, nullptr, capacity, count);
+}
+
+int lexer_next_tokens_with_symbols(lexer_session* session, lexer_token* tokens, int32_t* symbols,
+                                   size_t capacity, size_t* count) {
+    *count = 0;
+    if(!tokens && capacity > 0) {
+        return LEXER_INVALID_ARGUMENT;
+    }
+    try {
+        const std::string_view source = session->lexer->getSource();
+        while(!session->finished && *count < capacity) {
+            size_t scanned = session->lexer->next(session->batch.data(),
+                                                  std::min(capacity - *count, session->batch.size()));
+            for(size_t i = 0; i < scanned; ++i) {
+                const lexer::Token& token = session->batch[i];
+                if(symbols) {
+                    symbols[*count] = session->lexer->symbolId(token);
+                }
+                lexer_token& out = tokens[(*count)++];
+                out.category = token.getCategoryCode();
+                out.offset = static_cast<uint32_t>(token.getOffset());
+                out.length = static_cast<uint32_t>(token.getValue(source).size());
+                out.line = static_cast<uint32_t>(token.getLine());
+                out.column = static_cast<uint32_t>(token.getColumn());
+            }
+            session->finished = scanned > 0 &&
+                                session->batch[scanned - 1].getType() == lexer::TokenType::EOF_TOKEN;
+        }
+    } catch(...) {
+        session->finished = true;
+        return lexer::currentErrorCode();
+    }
+    return LEXER_OK;
+}
+
+size_t lexer_symbol_count(const lexer_session* session) {
+    return session->lexer->getSymbolTable().size();
+}
+
+const char* lexer_symbol_name(const lexer_session* session, size_t id, size_t* length) {
+    const auto& symbols = session->lexer->getSymbolTable().getAllSymbols();
+    if(id >= symbols.size()) {
+        return nullptr;
+    }
+    if(length) {
+        *length = symbols[id].name.size();
+    }
+    return symbols[id].name.data();
+}
+
+size_t lexer_error_count(const lexer_session* session) {
+    return session->lexer->getErrorCount();
+}
+
+size_t lexer_recorded_error_count(const lexer_session* session) {
+    return session->lexer->getErrors().size();
+}
+
+int lexer_get_error(const lexer_session* session, size_t index, lexer_error* error) {
+    const auto& errors = session->lexer->getErrors();
+    if(index >= errors.size()) {
+        return LEXER_INVALID_ARGUMENT;
+    }
+    const lexer::LexicalError& recorded = errors[index];
+    error->code = static_cast<int32_t>(recorded.getCode());
+    error->offset = static_cast<uint32_t>(recorded.getOffset());
+    error->length = static_cast<uint32_t>(recorded.getLength());
+    error->line = recorded.getLine();
+    error->column = recorded.getColumn();
+    return LEXER_OK;
+}
+
+size_t lexer_format_error(const lexer_session* session, size_t index, char* buffer, size_t size) {
+    const auto& errors = session->lexer->getErrors();
+    if(index >= errors.size()) {
+        return 0;
+    }
+    std::string text;
+    try {
+        text = errors[index].toString(session->lexer->getSource());
+    } catch(...) {
+        return 0;
+    }
+    if(size > 0) {
+        size_t copied = std::min(text.size(), size - 1);
+        std::memcpy(buffer, text.data(), copied);
+        buffer[copied] = '\0';
+    }
+    return text.size();
+}
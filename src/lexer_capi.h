@@ -0,0 +1,88 @@
+#ifndef LEXER_CAPI_H
+#define LEXER_CAPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 供其他语言和进程内嵌入使用的C接口，链接lexer_core库即可，无需调用命令行程序再解析结果文件。
+// 一个会话对应一个可复用的分析器：lexer_reset绑定一段源码，lexer_next_tokens把Token
+// 成批填入调用方的数组，符号表和错误在会话内直接读取。会话不是线程安全的，
+// 各线程应使用各自的会话。接口只增不改，LEXER_CAPI_VERSION随新增函数或返回值递增
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LEXER_CAPI_VERSION 1
+
+// lexer_create的功能位，与lexer_features.h中的同名功能取值相同
+#define LEXER_TRACK_POSITIONS 1u    // Token带行列号，否则为0
+#define LEXER_INTERN_SYMBOLS 2u     // 标识符登记到符号表，否则符号表为空
+#define LEXER_COLLECT_ERRORS 4u     // 记录错误，否则只计数
+#define LEXER_ALL_FEATURES 7u
+
+// 返回值
+#define LEXER_OK 0
+#define LEXER_INVALID_ARGUMENT (-1)
+#define LEXER_OUT_OF_MEMORY (-2)
+#define LEXER_SOURCE_TOO_LARGE (-3)     // 源码超过4GiB，超出Token偏移范围
+#define LEXER_INTERNAL_ERROR (-4)       // 其他内部错误
+
+typedef struct lexer_session lexer_session;
+
+typedef struct lexer_token {
+    int32_t category;       // 类别码（见README），最后一个Token为EOF（99）
+    uint32_t offset;        // 在源码中的字节偏移
+    uint32_t length;
+    uint32_t line;
+    uint32_t column;
+} lexer_token;
+
+// code取值：0非法字符，1标识符过长，2多行注释未闭合，3无效的UTF-8编码
+typedef struct lexer_error {
+    int32_t code;
+    uint32_t offset;
+    uint32_t length;
+    int32_t line;
+    int32_t column;
+} lexer_error;
+
+int lexer_capi_version(void);
+
+// features为上面功能位的组合；失败时返回NULL
+lexer_session* lexer_create(unsigned features);
+void lexer_destroy(lexer_session* session);
+
+// 之后每段源码最多记录limit个错误（0表示不限），须在lexer_reset之前设置
+void lexer_set_error_limit(lexer_session* session, size_t limit);
+// 开始分析source的前length个字节（遇到'\0'视为结束）。源码不拷贝，须在分析完、
+// 取完符号和错误之前保持有效。上一段源码的结果被清空，内部容量保留。
+// 失败时返回LEXER_SOURCE_TOO_LARGE等错误码，之后不再交出Token，须重新lexer_reset
+int lexer_reset(lexer_session* session, const char* source, size_t length);
+// 扫描至多capacity个Token写入tokens，*count为写入的个数；EOF写入后*count为0。
+// 内存不足时返回LEXER_OUT_OF_MEMORY（其他错误为LEXER_INTERNAL_ERROR），
+// 会话须重新lexer_reset后才能继续使用
+int lexer_next_tokens(lexer_session* session, lexer_token* tokens, size_t capacity, size_t* count);
+// 同lexer_next_tokens，另在symbols[i]中写出tokens[i]的符号id（见lexer_symbol_name），
+// 调用方按整数比较标识符即可。不是标识符或会话不登记符号时为-1；symbols可为NULL
+int lexer_next_tokens_with_symbols(lexer_session* session, lexer_token* tokens, int32_t* symbols,
+                                   size_t capacity, size_t* count);
+
+// 符号按id（首次出现顺序，从0开始）取出，名字指向会话内部的存储、不以'\0'结尾，
+// 在下一次lexer_reset或lexer_destroy之前有效，长度写入*length（length可为NULL）；id越界时返回NULL
+size_t lexer_symbol_count(const lexer_session* session);
+const char* lexer_symbol_name(const lexer_session* session, size_t id, size_t* length);
+
+// lexer_error_count含超过上限而未记录的错误，lexer_recorded_error_count只含记录下来的
+size_t lexer_error_count(const lexer_session* session);
+size_t lexer_recorded_error_count(const lexer_session* session);
+int lexer_get_error(const lexer_session* session, size_t index, lexer_error* error);
+// 按结果文件的格式写出第index个错误的描述，与snprintf相同：写入至多size-1个字节并以'\0'结尾，
+// 返回完整描述的长度；index越界时返回0
+size_t lexer_format_error(const lexer_session* session, size_t index, char* buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef LEXER_FEATURES_H
+#define LEXER_FEATURES_H
+
+#include <string_view>
+#include <type_traits>
+
+namespace lexer {
+
+// Lexer的可选功能，作为模板参数在编译期裁剪：关闭的功能在对应实例的扫描代码中不存在，
+// 而不是在运行时跳过
+enum LexerFeature : unsigned {
+    kTrackPositions = 1,    // 扫描时维护行列号；否则Token只记偏移，需要时经换行索引换算
+    kInternSymbols = 2,     // 标识符登记到符号表；否则符号表始终为空
+    kCollectErrors = 4,     // 记录错误；否则只计数
+    kKeepTokens = 8,        // tokenize()保存Token列表；否则只按类别计数
+    kAllFeatures = 15
+};
+
+// 结果文件的种类，命令行的--outputs与守护进程的请求共用。kSymbolRefs不是单独的文件，
+// 而是让Token序列中的标识符以符号id代替名字，默认不开启
+enum OutputKind : unsigned {
+    kTokensOutput = 1,
+    kSymbolsOutput = 2,
+    kErrorsOutput = 4,
+    kAllOutputs = 7,
+    kSymbolRefs = 8
+};
+
+template <unsigned Features>
+class BasicLexer;
+using Lexer = BasicLexer<kAllFeatures>;
+
+// 写出给定结果所需的最少功能。文本结果都不含Token位置，二进制Token流的位置在写出时换算
+constexpr unsigned featuresForOutputs(unsigned outputs, bool binary) {
+    if(binary) {
+        return kInternSymbols | kCollectErrors | kKeepTokens;
+    }
+    bool refs = (outputs & kTokensOutput) && (outputs & kSymbolRefs);
+    return ((outputs & kTokensOutput) ? kKeepTokens : 0u) |
+           ((outputs & kSymbolsOutput) || refs ? kInternSymbols : 0u) |
+           ((outputs & kErrorsOutput) ? kCollectErrors : 0u);
+}
+
+// 解析"tokens,symbols,errors,refs"的任意逗号分隔组合，"-"表示一个都不要
+inline bool parseOutputs(std::string_view text, unsigned& outputs) {
+    outputs = 0;
+    if(text == "-") {
+        return true;
+    }
+    while(!text.empty()) {
+        size_t comma = text.find(',');
+        std::string_view name = text.substr(0, comma);
+        if(name == "tokens") {
+            outputs |= kTokensOutput;
+        } else if(name == "symbols") {
+            outputs |= kSymbolsOutput;
+        } else if(name == "errors") {
+            outputs |= kErrorsOutput;
+        } else if(name == "refs") {
+            outputs |= kSymbolRefs;
+        } else {
+            return false;
+        }
+        text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+    }
+    return true;
+}
+
+// 把运行时决定的功能组合分派到对应的模板实例：以std::integral_constant<unsigned, F>调用function
+template <typename Function>
+decltype(auto) withLexerFeatures(unsigned features, Function&& function) {
+    switch(features & kAllFeatures) {
+    case 0: return function(std::integral_constant<unsigned, 0>());
+    case 1: return function(std::integral_constant<unsigned, 1>());
+    case 2: return function(std::integral_constant<unsigned, 2>());
+    case 3: return function(std::integral_constant<unsigned, 3>());
+    case 4: return function(std::integral_constant<unsigned, 4>());
+    case 5: return function(std::integral_constant<unsigned, 5>());
+    case 6: return function(std::integral_constant<unsigned, 6>());
+    case 7: return function(std::integral_constant<unsigned, 7>());
+    case 8: return function(std::integral_constant<unsigned, 8>());
+    case 9: return function(std::integral_constant<unsigned, 9>());
+    case 10: return function(std::integral_constant<unsigned, 10>());
+    case 11: return function(std::integral_constant<unsigned, 11>());
+    case 12: return function(std::integral_constant<unsigned, 12>());
+    case 13: return function(std::integral_constant<unsigned, 13>());
+    case 14: return function(std::integral_constant<unsigned, 14>());
+    default: return function(std::integral_constant<unsigned, 15>());
+    }
+}
+
+}
+
+#endif
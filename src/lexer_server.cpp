@@ -0,0 +1,452 @@
+#include "lexer_server.h"
+#include "lexer.h"
+#include "output_writer.h"
+#include "source_file.h"
+#include "thread_pool.h"
+#include <charconv>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace lexer {
+
+LexerServer::LexerServer(size_t threadCount, size_t errorLimit)
+    : threads_(threadCount == 0 ? 1 : threadCount), errorLimit_(errorLimit) {
+}
+
+#ifndef _WIN32
+
+namespace {
+
+// 应答写不出去（客户端不读）超过这么久即断开，免得占住工作线程
+constexpr int kSendTimeoutSeconds = 30;
+
+// 请求行为SOURCE且长度合法时返回其后源码的字节数，否则为0（其他请求和格式错误都只有一行）
+size_t sourceLength(std::string_view line) {
+    size_t first = line.find(' ');
+    size_t second = first == std::string_view::npos ? first : line.find(' ', first + 1);
+    if(second == std::string_view::npos || line.substr(0, first) != "SOURCE") {
+        return 0;
+    }
+    std::string_view argument = line.substr(second + 1);
+    size_t length = 0;
+    auto parsed = std::from_chars(argument.data(), argument.data() + argument.size(), length);
+    if(parsed.ec != std::errc() || parsed.ptr != argument.data() + argument.size() ||
+       length > LexerServer::kMaxSourceBytes) {
+        return 0;
+    }
+    return length;
+}
+
+// 连接上的带缓冲读取与整块写出
+class Connection {
+public:
+    Connection(int inFd, int outFd) : in_(inFd), out_(outFd), start_(0), lineTooLong_(false) {
+    }
+    
+    // 缓冲区中已有一个完整的请求（或超长的请求行），处理它不需要再读
+    bool hasRequest() const {
+        size_t newline = buffer_.find('\n', start_);
+        if(newline == std::string::npos) {
+            return buffer_.size() - start_ > LexerServer::kMaxLineBytes;
+        }
+        std::string_view line(buffer_.data() + start_, newline - start_);
+        return buffer_.size() - newline - 1 >= sourceLength(line);
+    }
+    
+    // 读一次已就绪的数据，输入结束或出错时返回false
+    bool receive() {
+        return fill();
+    }
+    
+    // 读取一行（不含'\n'），输入结束或行长超过上限时返回false
+    bool readLine(std::string& line) {
+        for(;;) {
+            size_t newline = buffer_.find('\n', start_);
+            if(newline != std::string::npos) {
+                line.assign(buffer_, start_, newline - start_);
+                start_ = newline + 1;
+                return true;
+            }
+            if(buffer_.size() - start_ > LexerServer::kMaxLineBytes) {
+                lineTooLong_ = true;
+                return false;
+            }
+            if(!fill()) {
+                return false;
+            }
+        }
+    }
+    
+    bool lineTooLong() const {
+        return lineTooLong_;
+    }
+    
+    bool readBytes(size_t count, std::string& out) {
+        while(buffer_.size() - start_ < count) {
+            if(!fill()) {
+                return false;
+            }
+        }
+        out.assign(buffer_, start_, count);
+        start_ += count;
+        return true;
+    }
+    
+    bool writeAll(std::string_view data) {
+        while(!data.empty()) {
+            ssize_t n = ::write(out_, data.data(), data.size());
+            if(n < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data.remove_prefix(static_cast<size_t>(n));
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t kReadSize = 64 * 1024;
+    
+    int in_;
+    int out_;
+    std::string buffer_;
+    size_t start_;
+    bool lineTooLong_;
+    
+    bool fill() {
+        // 已消费的部分移出缓冲区，避免其无限增长
+        if(start_ > 0) {
+            buffer_.erase(0, start_);
+            start_ = 0;
+        }
+        size_t used = buffer_.size();
+        buffer_.resize(used + kReadSize);
+        for(;;) {
+            ssize_t n = ::read(in_, &buffer_[used], kReadSize);
+            if(n < 0 && errno == EINTR) {
+                continue;
+            }
+            buffer_.resize(used + (n > 0 ? static_cast<size_t>(n) : 0));
+            return n > 0;
+        }
+    }
+};
+
+// 每个工作线程复用的缓冲区
+struct Session {
+    std::string line;
+    std::string body;
+    std::string response;
+    std::string section;
+};
+
+// 每个工作线程为每种功能组合各保留一个Lexer，在请求间复用
+template <unsigned Features>
+BasicLexer<Features>& sessionLexer() {
+    thread_local BasicLexer<Features> lexer{std::string_view()};
+    return lexer;
+}
+
+template <typename Write>
+void appendSection(Session& session, const char* name, Write write) {
+    session.section.clear();
+    {
+        OutputWriter out(session.section);
+        write(out);
+    }
+    session.response += name;
+    session.response += ' ';
+    session.response += std::to_string(session.section.size());
+    session.response += '\n';
+    session.response += session.section;
+}
+
+template <unsigned Features>
+void lexInto(Session& session, std::string_view source, unsigned mask, size_t errorLimit) {
+    using LexerType = BasicLexer<Features>;
+    LexerType& lex = sessionLexer<Features>();
+    lex.reset(source);
+    lex.setErrorLimit(errorLimit);
+    lex.tokenize();
+    session.response = "OK " + std::to_string(lex.getTokenCount()) + " " +
+                       std::to_string(lex.getSymbolTable().size()) + " " +
+                       std::to_string(lex.getErrorCount()) + "\n";
+    if(mask & kTokensOutput) {
+        appendSection(session, "tokens", [&](OutputWriter& out) { lex.writeTokens(out, (mask & kSymbolRefs) != 0); });
+    }
+    if(mask & kSymbolsOutput) {
+        appendSection(session, "symbols", [&](OutputWriter& out) { lex.writeSymbolTable(out); });
+    }
+    if(mask & kErrorsOutput) {
+        appendSection(session, "errors", [&](OutputWriter& out) { lex.writeErrors(out); });
+    }
+}
+
+// 应答行总要给出标识符数，因此始终登记符号；Token和错误只在请求了对应结果时收集
+void lexInto(Session& session, std::string_view source, unsigned mask, size_t errorLimit) {
+    withLexerFeatures(featuresForOutputs(mask, false) | kInternSymbols, [&](auto variant) {
+        lexInto<decltype(variant)::value>(session, source, mask, errorLimit);
+    });
+}
+
+// 处理一个请求；返回false表示连接应当关闭
+bool handleRequest(Connection& connection, Session& session, size_t errorLimit) {
+    const std::string& line = session.line;
+    size_t first = line.find(' ');
+    size_t second = first == std::string::npos ? first : line.find(' ', first + 1);
+    if(second == std::string::npos) {
+        return connection.writeAll("ERR 请求格式错误\n");
+    }
+    std::string_view command(line.data(), first);
+    std::string_view outputs(line.data() + first + 1, second - first - 1);
+    std::string_view argument(line.data() + second + 1, line.size() - second - 1);
+    
+    unsigned mask = 0;
+    bool outputsValid = parseOutputs(outputs, mask);
+    
+    if(command == "SOURCE") {
+        size_t length = 0;
+        auto parsed = std::from_chars(argument.data(), argument.data() + argument.size(), length);
+        if(parsed.ec != std::errc() || parsed.ptr != argument.data() + argument.size()) {
+            // 长度不可信时无法找到下一个请求的边界，只能断开
+            connection.writeAll("ERR 源码长度无效\n");
+            return false;
+        }
+        if(length > LexerServer::kMaxSourceBytes) {
+            // 不读取源码就无法找到下一个请求的边界，同样只能断开
+            connection.writeAll("ERR 源码超过" + std::to_string(LexerServer::kMaxSourceBytes >> 20) +
+                                "MiB上限，请改用PATH请求\n");
+            return false;
+        }
+        if(!connection.readBytes(length, session.body)) {
+            return false;
+        }
+        if(!outputsValid) {
+            return connection.writeAll("ERR 未知的输出类型\n");
+        }
+        lexInto(session, session.body, mask, errorLimit);
+    } else if(command == "PATH") {
+        if(!outputsValid) {
+            return connection.writeAll("ERR 未知的输出类型\n");
+        }
+        std::string path(argument);
+        std::unique_ptr<SourceFile> source;
+        try {
+            source = std::make_unique<SourceFile>(path);
+        } catch(const std::exception&) {
+            return connection.writeAll("ERR 无法打开文件: " + path + "\n");
+        }
+        // 分析和输出中的异常由serveConnection以其原因应答
+        lexInto(session, source->view(), mask, errorLimit);
+    } else {
+        return connection.writeAll("ERR 未知请求\n");
+    }
+    return connection.writeAll(session.response);
+}
+
+// 读取并处理一个请求；返回false表示连接应当关闭
+bool serveRequest(Connection& connection, size_t errorLimit) {
+    thread_local Session session;
+    if(!connection.readLine(session.line)) {
+        if(connection.lineTooLong()) {
+            connection.writeAll("ERR 请求行过长\n");
+        }
+        return false;
+    }
+    try {
+        return handleRequest(connection, session, errorLimit);
+    } catch(const std::exception& e) {
+        return connection.writeAll(std::string("ERR ") + e.what() + "\n");
+    }
+}
+
+// 析构时关闭的文件描述符
+struct UniqueFd {
+    int fd;
+    
+    explicit UniqueFd(int descriptor) : fd(descriptor) {
+    }
+    UniqueFd(const UniqueFd&) = delete;
+    UniqueFd& operator=(const UniqueFd&) = delete;
+    ~UniqueFd() {
+        if(fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+// 套接字上的一个客户端连接
+struct Client {
+    UniqueFd socket;
+    Connection connection;
+    
+    explicit Client(int fd) : socket(fd), connection(fd, fd) {
+    }
+};
+
+}
+
+void LexerServer::serveSocket(const std::string& socketPath) {
+    // 客户端中途断开时write返回EPIPE，而不是终止整个进程
+    std::signal(SIGPIPE, SIG_IGN);
+    
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("套接字路径过长: " + socketPath);
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    
+    // 清理上次运行留下的套接字文件，但不删除其他类型的文件
+    struct stat info;
+    if(::lstat(socketPath.c_str(), &info) == 0) {
+        if(!S_ISSOCK(info.st_mode)) {
+            throw std::runtime_error("路径已存在且不是套接字: " + socketPath);
+        }
+        ::unlink(socketPath.c_str());
+    }
+    
+    UniqueFd listener(::socket(AF_UNIX, SOCK_STREAM, 0));
+    if(listener.fd < 0) {
+        throw std::runtime_error("无法创建套接字: " + std::string(std::strerror(errno)));
+    }
+    if(::bind(listener.fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+       ::listen(listener.fd, SOMAXCONN) != 0) {
+        throw std::runtime_error("无法监听 " + socketPath + ": " + std::strerror(errno));
+    }
+    // 工作线程处理完一个连接上已收齐的请求后，把连接放回returned并经管道唤醒轮询。
+    // 管道两端都不阻塞：写满说明已有未处理的唤醒，读空即止
+    int pipeFds[2];
+    if(::pipe(pipeFds) != 0) {
+        throw std::runtime_error("无法创建管道: " + std::string(std::strerror(errno)));
+    }
+    UniqueFd wakeRead(pipeFds[0]);
+    UniqueFd wakeWrite(pipeFds[1]);
+    ::fcntl(wakeRead.fd, F_SETFL, O_NONBLOCK);
+    ::fcntl(wakeWrite.fd, F_SETFL, O_NONBLOCK);
+    std::mutex returnedMutex;
+    std::vector<std::unique_ptr<Client>> returned;
+    
+    // 本线程轮询所有空闲连接，只有收齐一个完整请求的连接才交给线程池，
+    // 连上后不发请求或请求发得很慢的客户端不会占住工作线程
+    std::vector<std::unique_ptr<Client>> idle;
+    std::vector<pollfd> polled;
+    ThreadPool pool(threads_);
+    auto dispatch = [&](std::unique_ptr<Client> client) {
+        pool.submit([client = client.release(), limit = errorLimit_, &returnedMutex, &returned, &wakeWrite] {
+            std::unique_ptr<Client> owned(client);
+            bool open = true;
+            while(open && owned->connection.hasRequest()) {
+                open = serveRequest(owned->connection, limit);
+            }
+            if(!open) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(returnedMutex);
+                returned.push_back(std::move(owned));
+            }
+            char wake = 0;
+            while(::write(wakeWrite.fd, &wake, 1) < 0 && errno == EINTR) {
+            }
+        });
+    };
+    
+    for(;;) {
+        polled.clear();
+        polled.push_back(pollfd{listener.fd, POLLIN, 0});
+        polled.push_back(pollfd{wakeRead.fd, POLLIN, 0});
+        for(const auto& client : idle) {
+            polled.push_back(pollfd{client->socket.fd, POLLIN, 0});
+        }
+        if(::poll(polled.data(), polled.size(), -1) < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("等待连接失败: " + std::string(std::strerror(errno)));
+        }
+        
+        // 先处理空闲连接上的数据，再加入新连接和放回的连接，polled与idle的下标保持对应
+        size_t kept = 0;
+        for(size_t i = 0; i < idle.size(); ++i) {
+            std::unique_ptr<Client>& client = idle[i];
+            if(polled[i + 2].revents != 0) {
+                // 输入结束时仍先处理已收齐的请求，连接放回后下一次读到结束再关闭
+                bool open = client->connection.receive();
+                if(client->connection.hasRequest()) {
+                    dispatch(std::move(client));
+                    continue;
+                }
+                if(!open) {
+                    client.reset();
+                    continue;
+                }
+            }
+            idle[kept++] = std::move(client);
+        }
+        idle.resize(kept);
+        
+        if(polled[0].revents & POLLIN) {
+            int fd = ::accept(listener.fd, nullptr, nullptr);
+            if(fd >= 0) {
+                timeval timeout{kSendTimeoutSeconds, 0};
+                ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                idle.push_back(std::make_unique<Client>(fd));
+            } else if(errno != EINTR && errno != ECONNABORTED && errno != EAGAIN) {
+                throw std::runtime_error("接受连接失败: " + std::string(std::strerror(errno)));
+            }
+        }
+        if(polled[1].revents & POLLIN) {
+            char drained[64];
+            while(::read(wakeRead.fd, drained, sizeof(drained)) > 0 || errno == EINTR) {
+            }
+            std::vector<std::unique_ptr<Client>> back;
+            {
+                std::lock_guard<std::mutex> lock(returnedMutex);
+                back.swap(returned);
+            }
+            for(auto& client : back) {
+                idle.push_back(std::move(client));
+            }
+        }
+    }
+}
+
+void LexerServer::serveStream(int inFd, int outFd) {
+    std::signal(SIGPIPE, SIG_IGN);
+    Connection connection(inFd, outFd);
+    while(serveRequest(connection, errorLimit_)) {
+    }
+}
+
+#else
+
+void LexerServer::serveSocket(const std::string&) {
+    throw std::runtime_error("当前平台不支持守护进程模式");
+}
+
+void LexerServer::serveStream(int, int) {
+    throw std::runtime_error("当前平台不支持守护进程模式");
+}
+
+#endif
+
+}
@@ -0,0 +1,34 @@
+#ifndef LEXER_SERVER_H
+#define LEXER_SERVER_H
+
+#include <cstddef>
+#include <string>
+
+namespace lexer {
+
+// 常驻服务：在Unix域套接字或一对文件描述符（标准输入输出）上接受成帧请求，
+// 省去每次调用的进程启动、文件系统检查和输出目录创建。协议见README
+class LexerServer {
+public:
+    // SOURCE请求的源码上限，更大的文件应以PATH请求（服务端直接映射文件）分析；
+    // 请求行的长度上限。超出时应答ERR并断开该连接，单个客户端无法让服务进程分配任意大的缓冲
+    static constexpr size_t kMaxSourceBytes = 64 << 20;
+    static constexpr size_t kMaxLineBytes = 64 << 10;
+    
+    // errorLimit为每个请求最多记录的错误数，0表示不限
+    LexerServer(size_t threadCount, size_t errorLimit);
+    
+    // 监听socketPath。调用线程轮询所有连接，收齐一个完整请求的连接才交给线程池处理，
+    // 空闲的连接不占用工作线程；连接内的请求顺序处理。只在出错时返回（抛出异常）
+    void serveSocket(const std::string& socketPath);
+    // 在inFd/outFd上顺序处理请求，直到输入结束
+    void serveStream(int inFd, int outFd);
+    
+private:
+    size_t threads_;
+    size_t errorLimit_;
+};
+
+}
+
+#endif
@@ -0,0 +1,246 @@
+#include "lexer_stats.h"
+#include "lexer.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace lexer {
+
+namespace {
+
+const char* typeName(int code) {
+    switch(static_cast<TokenType>(code)) {
+    case TokenType::VOID: return "VOID";
+    case TokenType::INT: return "INT";
+    case TokenType::FLOAT: return "FLOAT";
+    case TokenType::DOUBLE: return "DOUBLE";
+    case TokenType::IF: return "IF";
+    case TokenType::ELSE: return "ELSE";
+    case TokenType::FOR: return "FOR";
+    case TokenType::DO: return "DO";
+    case TokenType::WHILE: return "WHILE";
+    case TokenType::RETURN: return "RETURN";
+    case TokenType::IDENTIFIER: return "IDENTIFIER";
+    case TokenType::INTEGER: return "INTEGER";
+    case TokenType::PLUS: return "PLUS";
+    case TokenType::MINUS: return "MINUS";
+    case TokenType::MULTIPLY: return "MULTIPLY";
+    case TokenType::DIVIDE: return "DIVIDE";
+    case TokenType::ASSIGN: return "ASSIGN";
+    case TokenType::LT: return "LT";
+    case TokenType::GT: return "GT";
+    case TokenType::NOT: return "NOT";
+    case TokenType::INCREMENT: return "INCREMENT";
+    case TokenType::DECREMENT: return "DECREMENT";
+    case TokenType::PLUS_ASSIGN: return "PLUS_ASSIGN";
+    case TokenType::MINUS_ASSIGN: return "MINUS_ASSIGN";
+    case TokenType::MULTIPLY_ASSIGN: return "MULTIPLY_ASSIGN";
+    case TokenType::DIVIDE_ASSIGN: return "DIVIDE_ASSIGN";
+    case TokenType::EQUAL: return "EQUAL";
+    case TokenType::NOT_EQUAL: return "NOT_EQUAL";
+    case TokenType::LE: return "LE";
+    case TokenType::GE: return "GE";
+    case TokenType::LEFT_SHIFT: return "LEFT_SHIFT";
+    case TokenType::RIGHT_SHIFT: return "RIGHT_SHIFT";
+    case TokenType::AND: return "AND";
+    case TokenType::OR: return "OR";
+    case TokenType::SEMICOLON: return "SEMICOLON";
+    case TokenType::COMMA: return "COMMA";
+    case TokenType::LPAREN: return "LPAREN";
+    case TokenType::RPAREN: return "RPAREN";
+    case TokenType::LBRACE: return "LBRACE";
+    case TokenType::RBRACE: return "RBRACE";
+    case TokenType::EOF_TOKEN: return "EOF";
+    case TokenType::ERROR: return "ERROR";
+    }
+    return "UNKNOWN";
+}
+
+void writeEscaped(std::ostream& out, const std::string& text) {
+    out << '"';
+    for(char c : text) {
+        if(c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if(static_cast<unsigned char>(c) < 0x20) {
+            const char* digits = "0123456789abcdef";
+            out << "\\u00" << digits[(c >> 4) & 0xF] << digits[c & 0xF];
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+double perSecond(double amount, double seconds) {
+    return seconds > 0 ? amount / seconds : 0;
+}
+
+}
+
+StatsCollector::Phase::Phase(StatsCollector* collector, const char* name)
+    : collector_(collector), name_(name) {
+    if(collector_) {
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+StatsCollector::Phase::~Phase() {
+    if(collector_) {
+        collector_->addPhase(name_, std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start_).count());
+    }
+}
+
+StatsCollector::StatsCollector()
+    : mode_("single"), threads_(1), wallSeconds_(0), files_(0), cachedFiles_(0), inputBytes_(0),
+      typeCounts_{}, tokens_(0), errors_(0), symbols_(0), slots_(0), arenaBytes_(0),
+      inserts_(0), probes_(0), maxProbe_(0), tokenVectorPeak_(0), errorVectorPeak_(0) {
+}
+
+// 阶段按首次出现的顺序输出，数量很少，线性查找即可
+void StatsCollector::addPhase(const char* name, double seconds) {
+    for(auto& phase : phases_) {
+        if(phase.first == name) {
+            phase.second += seconds;
+            return;
+        }
+    }
+    phases_.emplace_back(name, seconds);
+}
+
+void StatsCollector::addInput(size_t bytes) {
+    files_++;
+    inputBytes_ += bytes;
+}
+
+template <unsigned Features>
+void StatsCollector::addLexer(const BasicLexer<Features>& lex) {
+    const auto counts = lex.getCategoryCounts();
+    for(size_t i = 0; i < kCategorySlots; ++i) {
+        typeCounts_[i] += counts[i];
+    }
+    tokens_ += lex.getTokenCount();
+    const auto& tokens = lex.getTokens();
+    
+    const auto& errors = lex.getErrors();
+    errors_ += lex.getErrorCount();
+    
+    SymbolTableStats table = lex.getSymbolTable().getStats();
+    symbols_ += table.symbols;
+    slots_ += table.slots;
+    arenaBytes_ += table.arenaBytes;
+    inserts_ += table.inserts;
+    probes_ += table.probes;
+    maxProbe_ = std::max<std::uint64_t>(maxProbe_, table.maxProbe);
+    
+    // 向量只增不减，当前容量就是峰值；错误信息在输出时才格式化，不占常驻内存
+    tokenVectorPeak_ = std::max<std::uint64_t>(tokenVectorPeak_, tokens.capacity() * sizeof(Token));
+    errorVectorPeak_ = std::max<std::uint64_t>(errorVectorPeak_, errors.capacity() * sizeof(LexicalError));
+}
+
+template void StatsCollector::addLexer(const BasicLexer<0>&);
+template void StatsCollector::addLexer(const BasicLexer<1>&);
+template void StatsCollector::addLexer(const BasicLexer<2>&);
+template void StatsCollector::addLexer(const BasicLexer<3>&);
+template void StatsCollector::addLexer(const BasicLexer<4>&);
+template void StatsCollector::addLexer(const BasicLexer<5>&);
+template void StatsCollector::addLexer(const BasicLexer<6>&);
+template void StatsCollector::addLexer(const BasicLexer<7>&);
+template void StatsCollector::addLexer(const BasicLexer<8>&);
+template void StatsCollector::addLexer(const BasicLexer<9>&);
+template void StatsCollector::addLexer(const BasicLexer<10>&);
+template void StatsCollector::addLexer(const BasicLexer<11>&);
+template void StatsCollector::addLexer(const BasicLexer<12>&);
+template void StatsCollector::addLexer(const BasicLexer<13>&);
+template void StatsCollector::addLexer(const BasicLexer<14>&);
+template void StatsCollector::addLexer(const BasicLexer<15>&);
+
+void StatsCollector::addCachedFile() {
+    cachedFiles_++;
+}
+
+void StatsCollector::merge(const StatsCollector& other) {
+    files_ += other.files_;
+    cachedFiles_ += other.cachedFiles_;
+    inputBytes_ += other.inputBytes_;
+    for(const auto& phase : other.phases_) {
+        addPhase(phase.first.c_str(), phase.second);
+    }
+    for(size_t i = 0; i < kCategorySlots; ++i) {
+        typeCounts_[i] += other.typeCounts_[i];
+    }
+    tokens_ += other.tokens_;
+    errors_ += other.errors_;
+    symbols_ += other.symbols_;
+    slots_ += other.slots_;
+    arenaBytes_ += other.arenaBytes_;
+    inserts_ += other.inserts_;
+    probes_ += other.probes_;
+    maxProbe_ = std::max(maxProbe_, other.maxProbe_);
+    tokenVectorPeak_ = std::max(tokenVectorPeak_, other.tokenVectorPeak_);
+    errorVectorPeak_ = std::max(errorVectorPeak_, other.errorVectorPeak_);
+}
+
+void StatsCollector::setRun(const char* mode, size_t threads, double wallSeconds) {
+    mode_ = mode;
+    threads_ = threads;
+    wallSeconds_ = wallSeconds;
+}
+
+void StatsCollector::writeJson(const std::string& filepath) const {
+    std::ofstream out(filepath);
+    if(!out) {
+        throw std::runtime_error("无法创建文件: " + filepath);
+    }
+    out.setf(std::ios::fixed);
+    out.precision(6);
+    
+    // 各阶段的吞吐量均按全部输入字节数和Token数计算；批处理时耗时为各文件之和
+    out << "{\n";
+    out << "  \"mode\": ";
+    writeEscaped(out, mode_);
+    out << ",\n  \"threads\": " << threads_;
+    out << ",\n  \"files\": " << files_;
+    out << ",\n  \"cached_files\": " << cachedFiles_;
+    out << ",\n  \"input_bytes\": " << inputBytes_;
+    out << ",\n  \"wall_seconds\": " << wallSeconds_;
+    out << ",\n  \"phases\": [";
+    for(size_t i = 0; i < phases_.size(); ++i) {
+        const auto& phase = phases_[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        writeEscaped(out, phase.first);
+        out << ", \"seconds\": " << phase.second
+            << ", \"mb_per_s\": " << perSecond(inputBytes_ / 1e6, phase.second)
+            << ", \"tokens_per_s\": " << perSecond(static_cast<double>(tokens_), phase.second) << "}";
+    }
+    out << "\n  ],\n";
+    
+    out << "  \"tokens\": {\n    \"total\": " << tokens_ << ",\n    \"by_type\": [";
+    bool first = true;
+    for(size_t i = 0; i < kCategorySlots; ++i) {
+        if(typeCounts_[i] == 0) {
+            continue;
+        }
+        int code = static_cast<int>(i) - 1;
+        out << (first ? "\n" : ",\n") << "      {\"code\": " << code << ", \"name\": \""
+            << typeName(code) << "\", \"count\": " << typeCounts_[i] << "}";
+        first = false;
+    }
+    out << "\n    ]\n  },\n";
+    
+    out << "  \"errors\": " << errors_ << ",\n";
+    out << "  \"symbols\": {\"count\": " << symbols_ << ", \"slots\": " << slots_
+        << ", \"load_factor\": " << (slots_ ? static_cast<double>(symbols_) / slots_ : 0.0)
+        << ", \"arena_bytes\": " << arenaBytes_
+        << ", \"inserts\": " << inserts_ << ", \"probes\": " << probes_
+        << ", \"average_probes\": " << (inserts_ ? static_cast<double>(probes_) / inserts_ : 0.0)
+        << ", \"max_probe\": " << maxProbe_ << "},\n";
+    out << "  \"memory\": {\"token_vector_peak_bytes\": " << tokenVectorPeak_
+        << ", \"error_vector_peak_bytes\": " << errorVectorPeak_ << "}\n";
+    out << "}\n";
+    if(!out.flush()) {
+        throw std::runtime_error("写入文件失败: " + filepath);
+    }
+}
+
+}
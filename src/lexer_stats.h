@@ -0,0 +1,76 @@
+#ifndef LEXER_STATS_H
+#define LEXER_STATS_H
+
+// 运行统计开关，由CMake选项LEXER_ENABLE_STATS控制。为0时符号表不再计数探测，
+// 命令行的--stats不可用，热路径上没有任何统计代码。SymbolTable的布局随之变化，
+// 库与使用方必须取同一个值，因此不提供默认值：由lexer_core的PUBLIC编译定义传给链接它的目标
+#ifndef LEXER_STATS
+#error "LEXER_STATS未定义：请链接CMake目标lexer_core，或自行定义为与库相同的0或1"
+#endif
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "lexer_features.h"
+#include "token_types.h"
+
+namespace lexer {
+
+// 汇总一次运行（单文件或批处理）的统计：各阶段耗时、Token类型直方图、
+// 符号表负载与探测次数、Token与错误向量占用的峰值内存。可按文件分别收集后合并
+class StatsCollector {
+public:
+    // 计时一个阶段，析构时把耗时累加到同名阶段；collector为空时什么都不做
+    class Phase {
+    public:
+        Phase(StatsCollector* collector, const char* name);
+        ~Phase();
+        Phase(const Phase&) = delete;
+        Phase& operator=(const Phase&) = delete;
+        
+    private:
+        StatsCollector* collector_;
+        const char* name_;
+        std::chrono::steady_clock::time_point start_;
+    };
+    
+    StatsCollector();
+    
+    void addPhase(const char* name, double seconds);
+    void addInput(size_t bytes);
+    // 在write*之后调用：读取Token、错误和符号表。各功能组合在lexer_stats.cpp中显式实例化
+    template <unsigned Features>
+    void addLexer(const BasicLexer<Features>& lex);
+    void addCachedFile();
+    void merge(const StatsCollector& other);
+    void setRun(const char* mode, size_t threads, double wallSeconds);
+    
+    void writeJson(const std::string& filepath) const;
+    
+private:
+    std::string mode_;
+    size_t threads_;
+    double wallSeconds_;
+    size_t files_;
+    size_t cachedFiles_;
+    std::uint64_t inputBytes_;
+    std::vector<std::pair<std::string, double>> phases_;
+    std::array<std::uint64_t, kCategorySlots> typeCounts_;
+    std::uint64_t tokens_;
+    std::uint64_t errors_;
+    std::uint64_t symbols_;
+    std::uint64_t slots_;
+    std::uint64_t arenaBytes_;
+    std::uint64_t inserts_;
+    std::uint64_t probes_;
+    std::uint64_t maxProbe_;
+    std::uint64_t tokenVectorPeak_;
+    std::uint64_t errorVectorPeak_;
+};
+
+}
+
+#endif
@@ -0,0 +1,49 @@
+#include "line_index.h"
+#include "simd_scan.h"
+#include <algorithm>
+
+namespace lexer {
+
+LineIndex::LineIndex(std::string_view source) {
+    assign(source);
+}
+
+void LineIndex::assign(std::string_view source) {
+    const char* data = source.data();
+    const char* end = data + source.size();
+    lineStarts_.clear();
+    lineStarts_.reserve(source.size() / 32 + 1);
+    lineStarts_.push_back(0);
+    for(const char* p = simd::findNewline(data, end); p != end; p = simd::findNewline(p + 1, end)) {
+        lineStarts_.push_back(static_cast<std::uint32_t>(p - data) + 1);
+    }
+}
+
+SourcePosition LineIndex::locate(size_t offset) const {
+    auto it = std::upper_bound(lineStarts_.begin(), lineStarts_.end(), offset);
+    size_t line = static_cast<size_t>(it - lineStarts_.begin()) - 1;
+    return SourcePosition{static_cast<int>(line) + 1,
+                          static_cast<int>(offset - lineStarts_[line]) + 1};
+}
+
+size_t LineIndex::lineCount() const {
+    return lineStarts_.size();
+}
+
+LineIndex::Cursor::Cursor(const LineIndex& index) : index_(&index), line_(0) {
+}
+
+SourcePosition LineIndex::Cursor::locate(size_t offset) {
+    const auto& starts = index_->lineStarts_;
+    // 通常只前进零或一行；跨越多行时（如分块扫描的首个错误）改用二分查找
+    if(line_ + 1 < starts.size() && starts[line_ + 1] <= offset) {
+        line_++;
+        if(line_ + 1 < starts.size() && starts[line_ + 1] <= offset) {
+            line_ = static_cast<size_t>(std::upper_bound(starts.begin() + line_ + 1, starts.end(), offset) -
+                                        starts.begin()) - 1;
+        }
+    }
+    return SourcePosition{static_cast<int>(line_) + 1, static_cast<int>(offset - starts[line_]) + 1};
+}
+
+}
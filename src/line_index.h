@@ -0,0 +1,42 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace lexer {
+
+struct SourcePosition {
+    int line;
+    int column;
+};
+
+// 换行偏移索引：一遍扫描记下每行行首的偏移，之后按二分查找把字节偏移换算成行列号
+class LineIndex {
+public:
+    explicit LineIndex(std::string_view source);
+    // 改为索引另一份源码，沿用已有容量
+    void assign(std::string_view source);
+    
+    SourcePosition locate(size_t offset) const;
+    size_t lineCount() const;
+    
+    // 按递增顺序换算一串偏移（如整个Token流或错误列表）时从上次的行继续向后找
+    class Cursor {
+    public:
+        explicit Cursor(const LineIndex& index);
+        SourcePosition locate(size_t offset);
+        
+    private:
+        const LineIndex* index_;
+        size_t line_;
+    };
+    
+private:
+    std::vector<std::uint32_t> lineStarts_;     // 下标为行号减1
+};
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+#include "output_writer.h"
+#include <filesystem>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <cstdio>
+#endif
+
+namespace lexer {
+
+namespace {
+
+// 输出文件可能是结果缓存条目的硬链接，截断重写前先断开，避免改写缓存内容
+void detachHardLink(const std::string& filepath) {
+    std::error_code ec;
+    if(std::filesystem::hard_link_count(filepath, ec) > 1 && !ec) {
+        std::filesystem::remove(filepath, ec);
+    }
+}
+
+}
+
+#ifndef _WIN32
+
+OutputWriter::OutputWriter(const std::string& filepath)
+    : path_(filepath), sink_(nullptr), buffer_(new char[kBufferSize]), used_(0) {
+    detachHardLink(filepath);
+    fd_ = ::open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd_ < 0) {
+        throw std::runtime_error("无法创建文件: " + filepath);
+    }
+}
+
+OutputWriter::OutputWriter(std::string& sink)
+    : sink_(&sink), buffer_(new char[kBufferSize]), used_(0), fd_(-1) {
+}
+
+OutputWriter::~OutputWriter() {
+    if(sink_) {
+        flush();
+    } else if(fd_ >= 0) {
+        try {
+            flush();
+        } catch(...) {
+        }
+        ::close(fd_);
+    }
+}
+
+void OutputWriter::close() {
+    if(sink_) {
+        flush();
+        return;
+    }
+    if(fd_ < 0) {
+        return;
+    }
+    flush();
+    int fd = fd_;
+    fd_ = -1;
+    if(::close(fd) != 0) {
+        throw std::runtime_error("写入文件失败: " + path_);
+    }
+}
+
+void OutputWriter::writeAll(const char* data, size_t size) {
+    while(size > 0) {
+        ssize_t n = ::write(fd_, data, size);
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("写入文件失败: " + path_);
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+#else
+
+OutputWriter::OutputWriter(const std::string& filepath)
+    : path_(filepath), sink_(nullptr), buffer_(new char[kBufferSize]), used_(0) {
+    detachHardLink(filepath);
+    file_ = std::fopen(filepath.c_str(), "wb");
+    if(!file_) {
+        throw std::runtime_error("无法创建文件: " + filepath);
+    }
+}
+
+OutputWriter::OutputWriter(std::string& sink)
+    : sink_(&sink), buffer_(new char[kBufferSize]), used_(0), file_(nullptr) {
+}
+
+OutputWriter::~OutputWriter() {
+    if(sink_) {
+        flush();
+    } else if(file_) {
+        try {
+            flush();
+        } catch(...) {
+        }
+        std::fclose(file_);
+    }
+}
+
+void OutputWriter::close() {
+    if(sink_) {
+        flush();
+        return;
+    }
+    if(!file_) {
+        return;
+    }
+    flush();
+    std::FILE* file = file_;
+    file_ = nullptr;
+    if(std::fclose(file) != 0) {
+        throw std::runtime_error("写入文件失败: " + path_);
+    }
+}
+
+void OutputWriter::writeAll(const char* data, size_t size) {
+    if(std::fwrite(data, 1, size, file_) != size) {
+        throw std::runtime_error("写入文件失败: " + path_);
+    }
+}
+
+#endif
+
+void OutputWriter::flush() {
+    if(used_ > 0) {
+        size_t size = used_;
+        used_ = 0;
+        emit(buffer_.get(), size);
+    }
+}
+
+void OutputWriter::emit(const char* data, size_t size) {
+    if(sink_) {
+        sink_->append(data, size);
+    } else {
+        writeAll(data, size);
+    }
+}
+
+// 放不进剩余空间时先清空缓冲区；仍比整个缓冲区大的内容直接写出
+void OutputWriter::appendSlow(std::string_view text) {
+    flush();
+    if(text.size() >= kBufferSize) {
+        emit(text.data(), text.size());
+        return;
+    }
+    std::memcpy(buffer_.get(), text.data(), text.size());
+    used_ = text.size();
+}
+
+}
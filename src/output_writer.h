@@ -0,0 +1,82 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <charconv>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace lexer {
+
+// 面向大输出的文件写入器：内容先格式化进一块可复用的大缓冲区（整数用std::to_chars），
+// 缓冲区满时以一次write系统调用整块写出，绕过iostream的locale与sentry开销。
+// 追加操作位于热循环中，故在头文件内联定义
+class OutputWriter {
+public:
+    explicit OutputWriter(const std::string& filepath);
+    // 写入内存：内容追加到sink末尾，供守护进程拼装响应
+    explicit OutputWriter(std::string& sink);
+    ~OutputWriter();
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+    
+    void append(std::string_view text) {
+        if(text.size() > kBufferSize - used_) {
+            appendSlow(text);
+            return;
+        }
+        std::memcpy(buffer_.get() + used_, text.data(), text.size());
+        used_ += text.size();
+    }
+    
+    void append(char c) {
+        if(used_ == kBufferSize) {
+            flush();
+        }
+        buffer_[used_++] = c;
+    }
+    
+    void appendInt(long long value) {
+        if(kBufferSize - used_ < kMaxIntChars) {
+            flush();
+        }
+        char* begin = buffer_.get() + used_;
+        used_ += static_cast<size_t>(std::to_chars(begin, begin + kMaxIntChars, value).ptr - begin);
+    }
+    
+    // 左对齐并以空格补足到width个字符，等价于 std::left << std::setw(width) << value
+    void appendIntPadded(long long value, size_t width) {
+        size_t before = used_;
+        appendInt(value);
+        for(size_t written = used_ - before; written < width; ++written) {
+            append(' ');
+        }
+    }
+    
+    void flush();
+    // 写出剩余内容并关闭文件，失败时抛出异常；析构时会自动关闭但不报告错误
+    void close();
+    
+private:
+    static constexpr size_t kBufferSize = 1 << 20;
+    static constexpr size_t kMaxIntChars = 24;
+    
+    std::string path_;
+    std::string* sink_;
+    std::unique_ptr<char[]> buffer_;
+    size_t used_;
+#ifdef _WIN32
+    std::FILE* file_;
+#else
+    int fd_;
+#endif
+    
+    void appendSlow(std::string_view text);
+    void emit(const char* data, size_t size);
+    void writeAll(const char* data, size_t size);
+};
+
+}
+
+#endif
@@ -0,0 +1,233 @@
+#include "parallel_lexer.h"
+#include "simd_scan.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace lexer {
+
+namespace {
+
+// 用threadCount个线程（含调用线程）领取并执行taskCount个任务
+template <typename Task>
+void runParallel(size_t taskCount, size_t threadCount, Task task) {
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for(size_t i = next.fetch_add(1); i < taskCount; i = next.fetch_add(1)) {
+            task(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for(size_t t = 1; t < threadCount && t < taskCount; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for(auto& thread : threads) {
+        thread.join();
+    }
+}
+
+template <unsigned Features>
+struct Chunk {
+    size_t begin;
+    size_t end;
+    simd::NewlineCount newlines;
+    int line;                   // 块首所在行
+    size_t lineStart;           // 块首所在行的行首偏移
+    std::unique_ptr<BasicLexer<Features>> lexer;
+    std::vector<Token> tokens;  // 仅保留Token的实例使用
+};
+
+}
+
+ParallelLexer::ParallelLexer(size_t threadCount, size_t minChunkSize)
+    : threadCount_(threadCount > 0 ? threadCount : 1), minChunkSize_(minChunkSize > 0 ? minChunkSize : 1) {
+}
+
+template <unsigned Features>
+const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<Features>& lexer) const {
+    using LexerType = BasicLexer<Features>;
+    const std::string_view source = lexer.source_;
+    const char* data = source.data();
+    const size_t begin = lexer.pos_;
+    const size_t length = source.length();
+    
+    size_t chunkCount = (length - begin) / minChunkSize_;
+    if(chunkCount > threadCount_ * kChunksPerThread) {
+        chunkCount = threadCount_ * kChunksPerThread;
+    }
+    if(threadCount_ == 1 || chunkCount < 2) {
+        return lexer.tokenize();
+    }
+    
+    // 块边界取在目标位置之后的第一个换行后面：Token不跨行，行首只可能处于
+    // “正常”或“多行注释内”两种状态
+    std::vector<Chunk<Features>> chunks;
+    size_t chunkBegin = begin;
+    for(size_t i = 1; i < chunkCount; ++i) {
+        size_t target = begin + (length - begin) / chunkCount * i;
+        if(target < chunkBegin) {
+            continue;
+        }
+        const char* newline = simd::findNewline(data + target, data + length);
+        if(newline == data + length) {
+            break;
+        }
+        size_t chunkEnd = static_cast<size_t>(newline - data) + 1;
+        chunks.push_back(Chunk<Features>{chunkBegin, chunkEnd, {0, nullptr}, 0, 0, nullptr, {}});
+        chunkBegin = chunkEnd;
+    }
+    chunks.push_back(Chunk<Features>{chunkBegin, length, {0, nullptr}, 0, 0, nullptr, {}});
+    
+    // 第一遍：并行统计各块的换行数，前缀和得到每块起始行；不维护行号时省去这一遍
+    constexpr bool track = LexerType::kTracksPositions;
+    if constexpr(track) {
+        runParallel(chunks.size(), threadCount_, [&](size_t i) {
+            chunks[i].newlines = simd::countNewlines(data + chunks[i].begin, data + chunks[i].end);
+        });
+    }
+    int line = lexer.line_;
+    size_t lineStart = lexer.lineStart_;
+    for(auto& chunk : chunks) {
+        chunk.line = line;
+        chunk.lineStart = chunk.begin == begin ? lineStart : chunk.begin;
+        line += static_cast<int>(chunk.newlines.count);
+        if(chunk.newlines.last) {
+            lineStart = static_cast<size_t>(chunk.newlines.last - data) + 1;
+        }
+    }
+    
+    // 第二遍：假定块首不在注释内，并行推测扫描
+    auto lexChunk = [&](Chunk<Features>& chunk, size_t from, int fromLine, size_t fromLineStart) {
+        chunk.lexer = std::make_unique<LexerType>(std::string_view());
+        LexerType& part = *chunk.lexer;
+        part.bindRange(source.substr(0, chunk.end), from, fromLine, fromLineStart);
+        part.deferOpenComment_ = true;
+        part.indexOwner_ = &lexer;
+        part.errorLimit_ = lexer.errorLimit_;
+        chunk.tokens.clear();
+        for(Token token = part.next(); token.getType() != TokenType::EOF_TOKEN; token = part.next()) {
+            if constexpr(LexerType::kKeepsTokens) {
+                chunk.tokens.push_back(token);
+            } else {
+                part.categoryCounts_[static_cast<size_t>(token.getCategoryCode() + 1)]++;
+                part.tokenCount_++;
+            }
+        }
+    };
+    runParallel(chunks.size(), threadCount_, [&](size_t i) {
+        lexChunk(chunks[i], chunks[i].begin, chunks[i].line, chunks[i].lineStart);
+    });
+    
+    // 顺序拼接；推测失败（块首实际处于注释内）的块从注释结束处重新扫描
+    size_t total = 0;
+    for(const auto& chunk : chunks) {
+        total += chunk.tokens.size();
+    }
+    if constexpr(LexerType::kKeepsTokens) {
+        lexer.tokens_.clear();
+        lexer.tokens_.reserve(total + 1);
+    }
+    
+    bool commentOpen = false;
+    size_t openOffset = 0;
+    int openLine = 0;
+    int openColumn = 0;
+    for(auto& chunk : chunks) {
+        if(commentOpen) {
+            const char* close = simd::findCommentClose(data + chunk.begin, data + chunk.end);
+            if(close == data + chunk.end) {
+                continue;
+            }
+            size_t resume = static_cast<size_t>(close - data) + 2;
+            simd::NewlineCount skipped = track ? simd::countNewlines(data + chunk.begin, data + resume)
+                                               : simd::NewlineCount{0, nullptr};
+            size_t resumeLineStart = skipped.last
+                ? static_cast<size_t>(skipped.last - data) + 1 : chunk.lineStart;
+            lexChunk(chunk, resume, chunk.line + static_cast<int>(skipped.count), resumeLineStart);
+            commentOpen = false;
+        }
+        
+        LexerType& part = *chunk.lexer;
+        // 按块顺序、块内按id顺序插入，合并后的id即为全文首次出现顺序；
+        // 块内标识符Token记的是块内的id，按remap换成合并后的id
+        std::vector<int> remap;
+        if constexpr(LexerType::kInternsSymbols) {
+            const auto& symbols = part.symbolTable_.getAllSymbols();
+            remap.resize(symbols.size());
+            for(const auto& symbol : symbols) {
+                remap[static_cast<size_t>(symbol.id)] = lexer.symbolTable_.insert(symbol.name);
+            }
+        }
+        if constexpr(LexerType::kKeepsTokens) {
+            size_t first = lexer.tokens_.size();
+            lexer.tokens_.insert(lexer.tokens_.end(), chunk.tokens.begin(), chunk.tokens.end());
+            if constexpr(LexerType::kInternsSymbols) {
+                for(size_t i = first; i < lexer.tokens_.size(); ++i) {
+                    Token& token = lexer.tokens_[i];
+                    if(token.getType() == TokenType::IDENTIFIER) {
+                        int id = token.getSymbolId();
+                        // 块内id超出Token的表示范围时按名字在合并后的符号表中查找
+                        token = token.withSymbolId(id >= 0 ? remap[static_cast<size_t>(id)] : lexer.symbolId(token));
+                    }
+                }
+            }
+        } else {
+            for(size_t slot = 0; slot < kCategorySlots; ++slot) {
+                lexer.categoryCounts_[slot] += part.categoryCounts_[slot];
+            }
+            lexer.tokenCount_ += part.tokenCount_;
+        }
+        size_t room = part.errors_.size();
+        if(lexer.errorLimit_ != 0) {
+            room = std::min(room, lexer.errorLimit_ - std::min(lexer.errorLimit_, lexer.errors_.size()));
+        }
+        lexer.errors_.insert(lexer.errors_.end(), part.errors_.begin(), part.errors_.begin() + room);
+        lexer.errorCount_ += part.errorCount_;
+        if(part.commentOpen_) {
+            commentOpen = true;
+            openOffset = part.openCommentOffset_;
+            openLine = part.openCommentLine_;
+            openColumn = part.openCommentColumn_;
+        }
+        chunk.lexer.reset();
+        std::vector<Token>().swap(chunk.tokens);
+    }
+    
+    lexer.pos_ = length;
+    lexer.currentChar_ = '\0';
+    lexer.line_ = line;
+    lexer.lineStart_ = lineStart;
+    if(commentOpen) {
+        lexer.reportUnterminatedComment(openOffset, openLine, openColumn);
+    }
+    SourcePosition end = lexer.tokenPosition();
+    Token eof = lexer.makeToken(TokenType::EOF_TOKEN, length, end.line, end.column);
+    if constexpr(LexerType::kKeepsTokens) {
+        lexer.tokens_.push_back(eof);
+    } else {
+        lexer.categoryCounts_[static_cast<size_t>(eof.getCategoryCode() + 1)]++;
+        lexer.tokenCount_++;
+    }
+    return lexer.tokens_;
+}
+
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<0>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<1>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<2>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<3>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<4>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<5>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<6>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<7>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<8>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<9>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<10>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<11>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<12>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<13>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<14>&) const;
+template const std::vector<Token>& ParallelLexer::tokenize(BasicLexer<15>&) const;
+
+}
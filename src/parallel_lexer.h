@@ -0,0 +1,34 @@
+#ifndef PARALLEL_LEXER_H
+#define PARALLEL_LEXER_H
+
+#include <vector>
+#include "lexer.h"
+
+namespace lexer {
+
+// 单个大文件的多线程词法分析：在换行处把源码切块，各块假定不在注释内并行扫描，
+// 再按顺序拼接；若前一块以未闭合的多行注释结束，则从注释结束处重新扫描该块。
+// 结果（Token、错误、符号表id）与串行的tokenize()逐字节一致
+class ParallelLexer {
+public:
+    // 块不小于minChunkSize字节，不足两块的输入直接串行扫描，线程开销不划算。
+    // 默认1 MiB；检查时可取很小的值，让块边界落在注释、长行等各种位置
+    static constexpr size_t kDefaultChunkSize = 1 << 20;
+    
+    explicit ParallelLexer(size_t threadCount, size_t minChunkSize = kDefaultChunkSize);
+    
+    // 并行扫描lexer尚未消费的源码，结果写回lexer，之后可直接调用其write*输出。
+    // 各功能组合在parallel_lexer.cpp中显式实例化
+    template <unsigned Features>
+    const std::vector<Token>& tokenize(BasicLexer<Features>& lexer) const;
+
+private:
+    static constexpr size_t kChunksPerThread = 4;
+    
+    size_t threadCount_;
+    size_t minChunkSize_;
+};
+
+}
+
+#endif
@@ -0,0 +1,260 @@
+#include "result_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace lexer {
+
+namespace {
+
+// 词法规则、类别码或结果文件格式变化时必须修改，使旧条目全部失效
+constexpr std::string_view kCacheVersion = "clex-1.0 token-spec-1 output-4 entry-2";
+
+const char* const kTokensName = "tokens.txt";
+const char* const kSymbolsName = "symbol_table.txt";
+const char* const kErrorsName = "errors.txt";
+const char* const kBinaryName = "tokens.bin";
+// 计数文件最后写入，其存在表示条目完整
+const char* const kCountsName = "counts";
+
+// 条目中的结果文件与目标的对应关系；计数文件按此顺序记录各文件的大小（不需要的为0）
+struct EntryFile {
+    const char* name;
+    std::string CacheTargets::*target;
+};
+
+const EntryFile kEntryFiles[] = {
+    {kTokensName, &CacheTargets::tokens},
+    {kSymbolsName, &CacheTargets::symbols},
+    {kErrorsName, &CacheTargets::errors},
+    {kBinaryName, &CacheTargets::binary},
+};
+constexpr size_t kEntryFileCount = sizeof(kEntryFiles) / sizeof(kEntryFiles[0]);
+
+constexpr auto kEvictInterval = std::chrono::minutes(1);
+// 超过这个时间仍未发布的临时目录视为崩溃进程的遗留
+constexpr auto kStaleStaging = std::chrono::hours(1);
+
+// 两路并行的64位乘法混合，一遍扫描得到128位摘要
+struct Hash128 {
+    std::uint64_t a;
+    std::uint64_t b;
+    
+    explicit Hash128(std::uint64_t seed) : a(seed ^ 0x243F6A8885A308D3ull), b(~seed ^ 0x13198A2E03707344ull) {
+    }
+    
+    void mix(std::uint64_t word) {
+        a = (a ^ word) * 0x9E3779B97F4A7C15ull;
+        a ^= a >> 29;
+        b = (b + word) * 0xC2B2AE3D27D4EB4Full;
+        b ^= b >> 31;
+    }
+    
+    void update(std::string_view data) {
+        const char* p = data.data();
+        size_t remaining = data.size();
+        while(remaining >= 8) {
+            std::uint64_t word;
+            std::memcpy(&word, p, 8);
+            mix(word);
+            p += 8;
+            remaining -= 8;
+        }
+        std::uint64_t tail = 0;
+        if(remaining > 0) {
+            std::memcpy(&tail, p, remaining);
+        }
+        mix(tail ^ (static_cast<std::uint64_t>(data.size()) << 8));
+    }
+};
+
+void appendHex(std::string& out, std::uint64_t value) {
+    static const char digits[] = "0123456789abcdef";
+    for(int shift = 60; shift >= 0; shift -= 4) {
+        out += digits[(value >> shift) & 0xF];
+    }
+}
+
+// 命中时把条目发到目标位置；硬链接失败（跨文件系统、不支持链接等）时退回复制
+bool linkOrCopy(const fs::path& from, const fs::path& to) {
+    std::error_code ec;
+    fs::remove(to, ec);
+    fs::create_hard_link(from, to, ec);
+    if(!ec) {
+        return true;
+    }
+    return fs::copy_file(from, to, fs::copy_options::overwrite_existing, ec) && !ec;
+}
+
+std::string uniqueSuffix() {
+    static std::atomic<unsigned> counter{0};
+    std::string suffix;
+    appendHex(suffix, std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                      static_cast<std::uint64_t>(
+                          std::chrono::steady_clock::now().time_since_epoch().count()));
+    suffix += '.';
+    suffix += std::to_string(counter.fetch_add(1));
+    return suffix;
+}
+
+}
+
+ResultCache::ResultCache(const std::string& directory, std::uint64_t maxBytes)
+    : directory_(directory), maxBytes_(maxBytes) {
+    // 缓存只是加速手段：目录不可用时所有查询都按未命中处理
+    std::error_code ec;
+    fs::create_directories(fs::path(directory_) / "tmp", ec);
+}
+
+std::string ResultCache::key(std::string_view source, bool withBinary, unsigned outputs, size_t errorLimit) {
+    Hash128 hash(source.size());
+    hash.update(kCacheVersion);
+    hash.update(withBinary ? "binary" : "text");
+    hash.update("outputs=" + std::to_string(outputs));
+    hash.update("max-errors=" + std::to_string(errorLimit));
+    hash.update(source);
+    std::string result;
+    result.reserve(32);
+    appendHex(result, hash.a);
+    appendHex(result, hash.b);
+    return result;
+}
+
+// 按键的前两位分散到子目录，避免单个目录条目过多
+std::string ResultCache::entryPath(const std::string& key) const {
+    return (fs::path(directory_) / key.substr(0, 2) / key).string();
+}
+
+bool ResultCache::fetch(const std::string& key, const CacheTargets& targets, CachedCounts& counts) const {
+    fs::path entry = entryPath(key);
+    std::uint64_t sizes[kEntryFileCount];
+    {
+        std::ifstream countsFile(entry / kCountsName);
+        if(!(countsFile >> counts.tokens >> counts.symbols >> counts.errors)) {
+            return false;
+        }
+        for(std::uint64_t& size : sizes) {
+            if(!(countsFile >> size)) {
+                return false;
+            }
+        }
+    }
+    std::error_code ec;
+    for(size_t i = 0; i < kEntryFileCount; ++i) {
+        const std::string& target = targets.*kEntryFiles[i].target;
+        if(target.empty()) {
+            continue;
+        }
+        // 发出去的硬链接被其他工具原地改写时缓存内容随之改变；大小不符即视为损坏，
+        // 删掉条目，由这次的分析结果重新收入
+        fs::path cached = entry / kEntryFiles[i].name;
+        std::uintmax_t size = fs::file_size(cached, ec);
+        if(ec || size != sizes[i]) {
+            fs::remove_all(entry, ec);
+            return false;
+        }
+        if(!linkOrCopy(cached, target)) {
+            return false;
+        }
+    }
+    // 目录的修改时间充当最近使用时间
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+void ResultCache::store(const std::string& key, const CacheTargets& targets, const CachedCounts& counts) const {
+    fs::path entry = entryPath(key);
+    fs::path staging = fs::path(directory_) / "tmp" / (key + "." + uniqueSuffix());
+    std::error_code ec;
+    fs::create_directories(staging, ec);
+    bool complete = !ec;
+    // 总是复制而不链接：targets是用户的输出文件，与条目共用inode时其他工具对它的原地修改会改坏缓存
+    std::uint64_t sizes[kEntryFileCount] = {};
+    for(size_t i = 0; complete && i < kEntryFileCount; ++i) {
+        const std::string& target = targets.*kEntryFiles[i].target;
+        if(target.empty()) {
+            continue;
+        }
+        fs::path cached = staging / kEntryFiles[i].name;
+        complete = fs::copy_file(target, cached, ec) && !ec;
+        sizes[i] = complete ? fs::file_size(cached, ec) : 0;
+        complete = complete && !ec;
+    }
+    if(complete) {
+        std::ofstream countsFile(staging / kCountsName);
+        countsFile << counts.tokens << ' ' << counts.symbols << ' ' << counts.errors;
+        for(std::uint64_t size : sizes) {
+            countsFile << ' ' << size;
+        }
+        countsFile << '\n';
+        complete = static_cast<bool>(countsFile.flush());
+    }
+    if(complete) {
+        fs::create_directories(entry.parent_path(), ec);
+        // 已有其他进程发布了同一条目时rename失败，内容相同，丢弃自己的即可
+        fs::rename(staging, entry, ec);
+    }
+    fs::remove_all(staging, ec);
+}
+
+void ResultCache::evict() const {
+    std::error_code ec;
+    fs::path stamp = fs::path(directory_) / "last-evict";
+    auto now = fs::file_time_type::clock::now();
+    auto last = fs::last_write_time(stamp, ec);
+    if(!ec && now - last < kEvictInterval) {
+        return;
+    }
+    std::ofstream(stamp).put('\n');
+    
+    for(const auto& staging : fs::directory_iterator(fs::path(directory_) / "tmp", ec)) {
+        auto modified = staging.last_write_time(ec);
+        if(!ec && now - modified > kStaleStaging) {
+            fs::remove_all(staging.path(), ec);
+        }
+    }
+    
+    struct Entry {
+        fs::path path;
+        fs::file_time_type used;
+        std::uint64_t bytes;
+    };
+    std::vector<Entry> entries;
+    std::uint64_t total = 0;
+    for(const auto& bucket : fs::directory_iterator(directory_, ec)) {
+        if(!bucket.is_directory(ec) || bucket.path().filename() == "tmp") {
+            continue;
+        }
+        for(const auto& item : fs::directory_iterator(bucket.path(), ec)) {
+            Entry entry{item.path(), item.last_write_time(ec), 0};
+            for(const auto& file : fs::directory_iterator(item.path(), ec)) {
+                auto size = file.file_size(ec);
+                entry.bytes += ec ? 0 : size;
+            }
+            total += entry.bytes;
+            entries.push_back(std::move(entry));
+        }
+    }
+    if(total <= maxBytes_) {
+        return;
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for(const auto& entry : entries) {
+        if(total <= maxBytes_) {
+            break;
+        }
+        fs::remove_all(entry.path, ec);
+        total -= entry.bytes;
+    }
+}
+
+}
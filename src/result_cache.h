@@ -0,0 +1,52 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace lexer {
+
+// 一次分析的结果文件位置；为空的项表示不需要该结果
+struct CacheTargets {
+    std::string tokens;
+    std::string symbols;
+    std::string errors;
+    std::string binary;
+};
+
+struct CachedCounts {
+    size_t tokens = 0;
+    size_t symbols = 0;
+    size_t errors = 0;
+};
+
+// 内容寻址的磁盘结果缓存。键由源码内容的128位哈希、长度、缓存版本和输出种类组成；
+// 命中时把缓存的结果文件硬链接（无法链接时复制）到目标位置，不再分析；收入时则总是复制，
+// 并记下各文件的大小，发出去的链接被原地改写后按未命中处理。
+// 条目先在临时目录中建好再rename发布，多个进程并发读写同一缓存目录是安全的
+class ResultCache {
+public:
+    // maxBytes为缓存总大小上限，超出后按最近使用时间淘汰
+    ResultCache(const std::string& directory, std::uint64_t maxBytes);
+    
+    // 键同时涵盖影响输出内容的选项；outputs为要求的文本结果（OutputKind的组合）
+    static std::string key(std::string_view source, bool withBinary, unsigned outputs, size_t errorLimit);
+    
+    // 命中时把结果放到targets并返回true；条目不完整、大小与记录不符或正被淘汰时按未命中处理
+    bool fetch(const std::string& key, const CacheTargets& targets, CachedCounts& counts) const;
+    // 把已写好的targets收入缓存，失败时静默放弃
+    void store(const std::string& key, const CacheTargets& targets, const CachedCounts& counts) const;
+    // 总大小超过上限时删除最久未使用的条目；同一缓存目录每分钟至多执行一次
+    void evict() const;
+    
+private:
+    std::string directory_;
+    std::uint64_t maxBytes_;
+    
+    std::string entryPath(const std::string& key) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,400 @@
+#include "simd_scan.h"
+#include "char_class.h"
+#include "utf8.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define LEXER_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(LEXER_SIMD_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define LEXER_SIMD_AVX2 1
+#include <immintrin.h>
+#define LEXER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace lexer {
+namespace simd {
+
+namespace {
+
+inline bool isWhitespace(char c) {
+    return classify(c) == CharClass::WHITESPACE;
+}
+
+inline unsigned countTrailingZeros(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+    unsigned n = 0;
+    while(!(mask & 1u)) {
+        mask >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+inline unsigned highestBit(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 31u - static_cast<unsigned>(__builtin_clz(mask));
+#else
+    unsigned n = 0;
+    while(mask >>= 1) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+inline unsigned popCount(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcount(mask));
+#else
+    unsigned n = 0;
+    for(; mask; mask &= mask - 1) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// ---------------- 标量实现 ----------------
+
+const char* skipWhitespaceScalar(const char* p, const char* end) {
+    while(p < end && isWhitespace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+const char* skipIdentCharsScalar(const char* p, const char* end) {
+    while(p < end && isIdentChar(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+const char* findNewlineScalar(const char* p, const char* end) {
+    const void* hit = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return hit ? static_cast<const char*>(hit) : end;
+}
+
+const char* findCommentCloseScalar(const char* p, const char* end) {
+    while(end - p >= 2) {
+        const void* hit = std::memchr(p, '*', static_cast<size_t>(end - p - 1));
+        if(!hit) {
+            return end;
+        }
+        p = static_cast<const char*>(hit);
+        if(p[1] == '/') {
+            return p;
+        }
+        ++p;
+    }
+    return end;
+}
+
+NewlineCount countNewlinesScalar(const char* p, const char* end) {
+    NewlineCount result{0, nullptr};
+    for(; p < end; ++p) {
+        if(*p == '\n') {
+            result.count++;
+            result.last = p;
+        }
+    }
+    return result;
+}
+
+// 从非ASCII字节开始逐个校验编码，直到下一个ASCII字节为止；遇到无效编码时停在其起点
+const char* validateNonAscii(const char* p, const char* end, bool& invalid) {
+    while(p < end && static_cast<unsigned char>(*p) >= 0x80) {
+        utf8::Sequence sequence = utf8::decode(p, end);
+        if(!sequence.valid) {
+            invalid = true;
+            return p;
+        }
+        p += sequence.length;
+    }
+    return p;
+}
+
+const char* findInvalidUtf8Scalar(const char* p, const char* end) {
+    while(p < end) {
+        if(static_cast<unsigned char>(*p) < 0x80) {
+            ++p;
+            continue;
+        }
+        bool invalid = false;
+        p = validateNonAscii(p, end, invalid);
+        if(invalid) {
+            return p;
+        }
+    }
+    return end;
+}
+
+// ---------------- SSE2 ----------------
+
+#ifdef LEXER_SIMD_SSE2
+
+// 字节落在[lo, hi]区间的掩码：平移到有符号区间底部后做一次有符号比较
+inline __m128i inRange16(__m128i v, char lo, char hi) {
+    __m128i shifted = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(-128 - lo)));
+    return _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(-128 + (hi - lo) + 1)));
+}
+
+inline unsigned whitespaceMask16(__m128i v) {
+    __m128i ws = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+    return static_cast<unsigned>(_mm_movemask_epi8(ws));
+}
+
+inline unsigned identMask16(__m128i v) {
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i ident = _mm_or_si128(
+        _mm_or_si128(inRange16(lower, 'a', 'z'), inRange16(v, '0', '9')),
+        _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    return static_cast<unsigned>(_mm_movemask_epi8(ident));
+}
+
+const char* skipWhitespaceSse2(const char* p, const char* end) {
+    while(end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned stop = ~whitespaceMask16(v) & 0xFFFFu;
+        if(stop) {
+            return p + countTrailingZeros(stop);
+        }
+        p += 16;
+    }
+    return skipWhitespaceScalar(p, end);
+}
+
+const char* skipIdentCharsSse2(const char* p, const char* end) {
+    while(end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned stop = ~identMask16(v) & 0xFFFFu;
+        if(stop) {
+            return p + countTrailingZeros(stop);
+        }
+        p += 16;
+    }
+    return skipIdentCharsScalar(p, end);
+}
+
+const char* findCommentCloseSse2(const char* p, const char* end) {
+    // 同时比较p[i]=='*'与p[i+1]=='/'，一次定位完整的"*/"
+    while(end - p >= 17) {
+        __m128i star = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                                      _mm_set1_epi8('*'));
+        __m128i slash = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)),
+                                       _mm_set1_epi8('/'));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(star, slash)));
+        if(mask) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 16;
+    }
+    return findCommentCloseScalar(p, end);
+}
+
+NewlineCount countNewlinesSse2(const char* p, const char* end) {
+    NewlineCount result{0, nullptr};
+    while(end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+        if(mask) {
+            result.count += popCount(mask);
+            result.last = p + highestBit(mask);
+        }
+        p += 16;
+    }
+    NewlineCount tail = countNewlinesScalar(p, end);
+    result.count += tail.count;
+    if(tail.last) {
+        result.last = tail.last;
+    }
+    return result;
+}
+
+const char* findInvalidUtf8Sse2(const char* p, const char* end) {
+    while(end - p >= 16) {
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+        if(!mask) {
+            p += 16;
+            continue;
+        }
+        bool invalid = false;
+        p = validateNonAscii(p + countTrailingZeros(mask), end, invalid);
+        if(invalid) {
+            return p;
+        }
+    }
+    return findInvalidUtf8Scalar(p, end);
+}
+
+#endif
+
+// ---------------- AVX2 ----------------
+
+#ifdef LEXER_SIMD_AVX2
+
+LEXER_TARGET_AVX2 inline __m256i inRange32(__m256i v, char lo, char hi) {
+    __m256i shifted = _mm256_add_epi8(v, _mm256_set1_epi8(static_cast<char>(-128 - lo)));
+    return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + (hi - lo) + 1)), shifted);
+}
+
+LEXER_TARGET_AVX2 const char* skipWhitespaceAvx2(const char* p, const char* end) {
+    while(end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(ws));
+        if(stop) {
+            return p + countTrailingZeros(stop);
+        }
+        p += 32;
+    }
+    return skipWhitespaceSse2(p, end);
+}
+
+LEXER_TARGET_AVX2 const char* skipIdentCharsAvx2(const char* p, const char* end) {
+    while(end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i ident = _mm256_or_si256(
+            _mm256_or_si256(inRange32(lower, 'a', 'z'), inRange32(v, '0', '9')),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(ident));
+        if(stop) {
+            return p + countTrailingZeros(stop);
+        }
+        p += 32;
+    }
+    return skipIdentCharsSse2(p, end);
+}
+
+LEXER_TARGET_AVX2 const char* findCommentCloseAvx2(const char* p, const char* end) {
+    while(end - p >= 33) {
+        __m256i star = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)),
+                                         _mm256_set1_epi8('*'));
+        __m256i slash = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1)),
+                                          _mm256_set1_epi8('/'));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(star, slash)));
+        if(mask) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 32;
+    }
+    return findCommentCloseSse2(p, end);
+}
+
+LEXER_TARGET_AVX2 NewlineCount countNewlinesAvx2(const char* p, const char* end) {
+    NewlineCount result{0, nullptr};
+    while(end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+        if(mask) {
+            result.count += popCount(mask);
+            result.last = p + highestBit(mask);
+        }
+        p += 32;
+    }
+    NewlineCount tail = countNewlinesSse2(p, end);
+    result.count += tail.count;
+    if(tail.last) {
+        result.last = tail.last;
+    }
+    return result;
+}
+
+LEXER_TARGET_AVX2 const char* findInvalidUtf8Avx2(const char* p, const char* end) {
+    while(end - p >= 32) {
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))));
+        if(!mask) {
+            p += 32;
+            continue;
+        }
+        bool invalid = false;
+        p = validateNonAscii(p + countTrailingZeros(mask), end, invalid);
+        if(invalid) {
+            return p;
+        }
+    }
+    return findInvalidUtf8Sse2(p, end);
+}
+
+#endif
+
+struct Dispatch {
+    const char* (*skipWhitespace)(const char*, const char*);
+    const char* (*skipIdentChars)(const char*, const char*);
+    const char* (*findCommentClose)(const char*, const char*);
+    NewlineCount (*countNewlines)(const char*, const char*);
+    const char* (*findInvalidUtf8)(const char*, const char*);
+    const char* isa;
+};
+
+Dispatch selectDispatch() {
+#ifdef LEXER_SIMD_AVX2
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        return {skipWhitespaceAvx2, skipIdentCharsAvx2, findCommentCloseAvx2,
+                countNewlinesAvx2, findInvalidUtf8Avx2, "avx2"};
+    }
+#endif
+#ifdef LEXER_SIMD_SSE2
+    return {skipWhitespaceSse2, skipIdentCharsSse2, findCommentCloseSse2,
+            countNewlinesSse2, findInvalidUtf8Sse2, "sse2"};
+#else
+    return {skipWhitespaceScalar, skipIdentCharsScalar, findCommentCloseScalar,
+            countNewlinesScalar, findInvalidUtf8Scalar, "scalar"};
+#endif
+}
+
+const Dispatch& dispatch() {
+    static const Dispatch table = selectDispatch();
+    return table;
+}
+
+}
+
+const char* skipWhitespace(const char* begin, const char* end) {
+    return dispatch().skipWhitespace(begin, end);
+}
+
+const char* skipIdentChars(const char* begin, const char* end) {
+    return dispatch().skipIdentChars(begin, end);
+}
+
+const char* findNewline(const char* begin, const char* end) {
+    // libc的memchr本身已是向量化实现
+    return findNewlineScalar(begin, end);
+}
+
+const char* findCommentClose(const char* begin, const char* end) {
+    return dispatch().findCommentClose(begin, end);
+}
+
+NewlineCount countNewlines(const char* begin, const char* end) {
+    return dispatch().countNewlines(begin, end);
+}
+
+const char* findInvalidUtf8(const char* begin, const char* end) {
+    return dispatch().findInvalidUtf8(begin, end);
+}
+
+const char* activeIsa() {
+    return dispatch().isa;
+}
+
+}
+}
@@ -0,0 +1,32 @@
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <cstddef>
+
+namespace lexer {
+namespace simd {
+
+// 成批扫描的快速路径：首次调用时按CPU能力选择AVX2、SSE2或标量实现。
+// 所有函数都在[begin, end)内查找，找不到时返回end
+const char* skipWhitespace(const char* begin, const char* end);
+const char* skipIdentChars(const char* begin, const char* end);
+const char* findNewline(const char* begin, const char* end);
+// 返回"*/"中'*'的位置
+const char* findCommentClose(const char* begin, const char* end);
+
+struct NewlineCount {
+    size_t count;
+    const char* last;   // 最后一个'\n'的位置，没有换行时为nullptr
+};
+NewlineCount countNewlines(const char* begin, const char* end);
+
+// 返回第一个无效UTF-8编码的起点；纯ASCII的块整块跳过，只逐个校验非ASCII的编码
+const char* findInvalidUtf8(const char* begin, const char* end);
+
+// 当前选用的实现："avx2"、"sse2"或"scalar"
+const char* activeIsa();
+
+}
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include "source_file.h"
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace lexer {
+
+#ifndef _WIN32
+
+SourceFile::SourceFile(const std::string& path)
+    : data_(nullptr), size_(0), mapped_(false) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw std::runtime_error("无法打开文件: " + path);
+    }
+    
+    struct stat st;
+    // 大小为0的普通文件可能是procfs等伪文件，同样走缓冲读取
+    if(::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                            MAP_PRIVATE, fd, 0);
+        if(addr != MAP_FAILED) {
+            ::madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(addr);
+            size_ = static_cast<size_t>(st.st_size);
+            mapped_ = true;
+        }
+    }
+    
+    if(!mapped_) {
+        try {
+            readBuffered(fd);
+        } catch(...) {
+            ::close(fd);
+            throw;
+        }
+    }
+    ::close(fd);
+}
+
+SourceFile::~SourceFile() {
+    if(mapped_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+void SourceFile::readBuffered(int fd) {
+    char chunk[65536];
+    for(;;) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("读取输入失败");
+        }
+        if(n == 0) {
+            break;
+        }
+        buffer_.append(chunk, static_cast<size_t>(n));
+    }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+#else
+
+SourceFile::SourceFile(const std::string& path)
+    : data_(nullptr), size_(0), mapped_(false) {
+    std::ifstream in(path, std::ios::binary);
+    if(!in) {
+        throw std::runtime_error("无法打开文件: " + path);
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+SourceFile::~SourceFile() {
+}
+
+#endif
+
+std::string_view SourceFile::view() const {
+    return std::string_view(data_, size_);
+}
+
+bool SourceFile::isMapped() const {
+    return mapped_;
+}
+
+}
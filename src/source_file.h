@@ -0,0 +1,31 @@
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+#include <string>
+#include <string_view>
+
+namespace lexer {
+
+// 只读输入文件：普通文件以mmap映射，管道、设备等特殊文件退回缓冲读取
+class SourceFile {
+public:
+    explicit SourceFile(const std::string& path);
+    ~SourceFile();
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+    
+    std::string_view view() const;
+    bool isMapped() const;
+    
+private:
+    const char* data_;
+    size_t size_;
+    bool mapped_;
+    std::string buffer_;
+    
+    void readBuffered(int fd);
+};
+
+}
+
+#endif
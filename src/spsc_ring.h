@@ -0,0 +1,106 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace lexer {
+
+// 单生产者单消费者的无锁环形队列，在流水线各阶段之间传递缓冲块。
+// tail_只由生产者写、head_只由消费者写，两端互不加锁；环满时push等待，对上游形成背压，
+// 环空时pop等待。等待时先自旋，再让出CPU，仍未就绪则在条件变量上休眠，由对端的push/pop/close唤醒，
+// I/O长时间阻塞时既不空耗CPU，也不会在就绪后还要等到下一次轮询
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "环的容量须为2的幂");
+
+public:
+    SpscRing() : head_(0), tail_(0), closed_(false), sleepers_(0) {
+    }
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+    
+    // 生产者调用；环已关闭（消费者放弃）时不再放入并返回false
+    bool push(T&& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        waitUntil([&] {
+            return closed_.load(std::memory_order_seq_cst) || tail - head_.load(std::memory_order_seq_cst) < Capacity;
+        });
+        if(closed_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots_[tail & (Capacity - 1)] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_seq_cst);
+        wakeSleepers();
+        return true;
+    }
+    
+    // 消费者调用；环已关闭且关闭前放入的元素都已取出时返回false
+    bool pop(T& value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        waitUntil([&] {
+            return tail_.load(std::memory_order_seq_cst) != head || closed_.load(std::memory_order_seq_cst);
+        });
+        if(tail_.load(std::memory_order_acquire) == head) {
+            return false;
+        }
+        value = std::move(slots_[head & (Capacity - 1)]);
+        head_.store(head + 1, std::memory_order_seq_cst);
+        wakeSleepers();
+        return true;
+    }
+    
+    // 任一端调用：生产者表示不再有新元素，消费者表示不再取用
+    void close() {
+        closed_.store(true, std::memory_order_seq_cst);
+        std::lock_guard<std::mutex> lock(mutex_);
+        wakeup_.notify_all();
+    }
+
+private:
+    static constexpr unsigned kSpinRounds = 16;
+    static constexpr unsigned kYieldRounds = 64;
+    
+    std::array<T, Capacity> slots_;
+    // 两个下标分处不同缓存行，避免生产者和消费者互相使对方的缓存行失效
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+    std::atomic<bool> closed_;
+    // 休眠的一端先登记到sleepers_再检查条件；另一端改下标后检查sleepers_，有人休眠才加锁唤醒。
+    // 两边的写和读都是seq_cst，至少一方能看到对方的写，不会漏掉唤醒，平时push/pop也不碰锁
+    std::atomic<unsigned> sleepers_;
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    
+    template <typename Ready>
+    void waitUntil(Ready ready) {
+        for(unsigned round = 0; round < kYieldRounds; ++round) {
+            if(ready()) {
+                return;
+            }
+            if(round >= kSpinRounds) {
+                std::this_thread::yield();
+            }
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        wakeup_.wait(lock, ready);
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    
+    void wakeSleepers() {
+        if(sleepers_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wakeup_.notify_all();
+        }
+    }
+};
+
+}
+
+#endif
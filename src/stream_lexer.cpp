@@ -0,0 +1,225 @@
+#include "stream_lexer.h"
+#include "output_writer.h"
+#include "simd_scan.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace lexer {
+
+StreamLexer::ReadFunction StreamLexer::openInput(const std::string& path) {
+    std::shared_ptr<std::FILE> file;
+    if(path == "-") {
+        file.reset(stdin, [](std::FILE*) {});
+    } else {
+        file.reset(std::fopen(path.c_str(), "rb"), [](std::FILE* opened) {
+            if(opened) {
+                std::fclose(opened);
+            }
+        });
+        if(!file) {
+            throw std::runtime_error("无法打开文件: " + path);
+        }
+    }
+    return [file](char* data, size_t size) {
+        size_t n = std::fread(data, 1, size, file.get());
+        if(n == 0 && std::ferror(file.get())) {
+            throw std::runtime_error("读取输入失败");
+        }
+        return n;
+    };
+}
+
+StreamLexer::StreamLexer(const std::string& path, size_t windowSize)
+    : StreamLexer(openInput(path), windowSize) {
+}
+
+StreamLexer::StreamLexer(ReadFunction read, size_t windowSize)
+    : read_(std::move(read)), windowSize_(windowSize > 0 ? windowSize : kDefaultWindow), filled_(0),
+      cut_(0), eof_(false), done_(false), bytesRead_(0), lexer_(std::string_view()), line_(1),
+      lineCarry_(0), commentOpen_(false), lineCommentOpen_(false), openLine_(0), openColumn_(0), errorLimit_(0), recorded_(0), tokenCount_(0) {
+    buffer_.resize(windowSize_);
+}
+
+// 读到缓冲区满或输入结束；与一次性分析一致，遇到'\0'即视为输入结束
+void StreamLexer::fill() {
+    while(!eof_ && filled_ < buffer_.size()) {
+        size_t n = read_(&buffer_[filled_], buffer_.size() - filled_);
+        if(n == 0) {
+            eof_ = true;
+            break;
+        }
+        const void* nul = std::memchr(&buffer_[filled_], '\0', n);
+        if(nul) {
+            n = static_cast<size_t>(static_cast<const char*>(nul) - &buffer_[filled_]);
+            eof_ = true;
+        }
+        filled_ += n;
+        bytesRead_ += n;
+    }
+}
+
+bool StreamLexer::next() {
+    if(done_) {
+        return false;
+    }
+    // 上一个窗口之后剩下的部分移到开头；扩大过的缓冲区在放得下时恢复原大小
+    std::memmove(&buffer_[0], buffer_.data() + cut_, filled_ - cut_);
+    filled_ -= cut_;
+    cut_ = 0;
+    if(buffer_.size() > windowSize_ && filled_ <= windowSize_) {
+        buffer_.resize(windowSize_);
+        buffer_.shrink_to_fit();
+    }
+    
+    for(;;) {
+        fill();
+        if(eof_) {
+            cut_ = filled_;
+            break;
+        }
+        const std::string_view filled(buffer_.data(), filled_);
+        size_t newline = filled.rfind('\n');
+        if(newline != std::string_view::npos) {
+            cut_ = newline + 1;
+            break;
+        }
+        // 没有换行就在最后一个空白之后切开：空白前后不会连成一个Token，也拆不开注释的定界符
+        size_t blank = filled.find_last_of(" \t\r");
+        if(blank != std::string_view::npos) {
+            cut_ = blank + 1;
+            break;
+        }
+        if(buffer_.size() / kMaxWindowGrowth >= windowSize_) {
+            throw std::runtime_error("输入中有一段超过 " + std::to_string(buffer_.size()) +
+                                     " 字节且不含换行和空白，超出流式分析的窗口上限");
+        }
+        buffer_.resize(buffer_.size() * 2);
+    }
+    
+    lexWindow();
+    done_ = eof_;
+    return true;
+}
+
+void StreamLexer::lexWindow() {
+    const std::string_view source(buffer_.data(), cut_);
+    const char* data = source.data();
+    const char* end = data + source.length();
+    
+    // 上一个窗口结束在注释内：从注释结束处开始扫描，跳过的部分只计行号。
+    // 在行中间切开时行首落在窗口之前，列号按无符号差计算，行首以回绕的偏移表示即可
+    size_t begin = 0;
+    int line = line_;
+    size_t lineStart = 0 - lineCarry_;
+    if(lineCommentOpen_) {
+        const char* newline = simd::findNewline(data, end);
+        begin = static_cast<size_t>(newline - data);
+        lineCommentOpen_ = newline == end;
+    } else if(commentOpen_) {
+        const char* close = simd::findCommentClose(data, end);
+        begin = close != end ? static_cast<size_t>(close - data) + 2 : source.length();
+        simd::NewlineCount skipped = simd::countNewlines(data, data + begin);
+        line += static_cast<int>(skipped.count);
+        if(skipped.last) {
+            lineStart = static_cast<size_t>(skipped.last - data) + 1;
+        }
+        commentOpen_ = close == end;
+    }
+    
+    lexer_.tokens_.clear();
+    lexer_.errors_.clear();
+    lexer_.bindRange(source, begin, line, lineStart);
+    lexer_.deferOpenComment_ = !eof_;
+    size_t room = errorLimit_ - std::min(errorLimit_, recorded_);
+    lexer_.errorLimit_ = errorLimit_ != 0 && room > 0 ? room : errorLimit_;
+    
+    for(Token token = lexer_.next();; token = lexer_.next()) {
+        if(token.getType() != TokenType::EOF_TOKEN || eof_) {
+            lexer_.tokens_.push_back(token);
+        }
+        if(token.getType() == TokenType::EOF_TOKEN) {
+            break;
+        }
+    }
+    lineCommentOpen_ = lineCommentOpen_ || lexer_.lineCommentOpen_;
+    if(lexer_.commentOpen_) {
+        commentOpen_ = true;
+        openLine_ = lexer_.openCommentLine_;
+        openColumn_ = lexer_.openCommentColumn_;
+    }
+    if(eof_ && commentOpen_) {
+        // 偏移不参与该错误信息的格式化
+        lexer_.reportUnterminatedComment(0, openLine_, openColumn_);
+    }
+    if(errorLimit_ != 0 && lexer_.errors_.size() > room) {
+        lexer_.errors_.erase(lexer_.errors_.begin() + static_cast<std::ptrdiff_t>(room), lexer_.errors_.end());
+    }
+    
+    line_ = lexer_.line_;
+    lineCarry_ = cut_ - lexer_.lineStart_;
+    recorded_ += lexer_.errors_.size();
+    tokenCount_ += lexer_.tokens_.size();
+}
+
+std::string_view StreamLexer::window() const {
+    return std::string_view(buffer_.data(), cut_);
+}
+
+const std::vector<Token>& StreamLexer::tokens() const {
+    return lexer_.getTokens();
+}
+
+const std::vector<LexicalError>& StreamLexer::errors() const {
+    return lexer_.getErrors();
+}
+
+void StreamLexer::setErrorLimit(size_t limit) {
+    errorLimit_ = limit;
+}
+
+size_t StreamLexer::getTokenCount() const {
+    return tokenCount_;
+}
+
+size_t StreamLexer::getErrorCount() const {
+    return lexer_.getErrorCount();
+}
+
+size_t StreamLexer::getBytesRead() const {
+    return bytesRead_;
+}
+
+const SymbolTable& StreamLexer::getSymbolTable() const {
+    return lexer_.getSymbolTable();
+}
+
+void StreamLexer::writeTokens(OutputWriter& out, bool symbolRefs) const {
+    lexer_.writeTokens(out, symbolRefs);
+}
+
+void StreamLexer::writeErrors(OutputWriter& out) const {
+    for(const auto& error : lexer_.getErrors()) {
+        error.appendTo(out, window());
+        out.append('\n');
+    }
+    if(!done_) {
+        return;
+    }
+    if(recorded_ == 0) {
+        out.append("无错误\n");
+    } else if(getErrorCount() > recorded_) {
+        out.append("另有 ");
+        out.appendInt(static_cast<long long>(getErrorCount() - recorded_));
+        out.append(" 个错误超出记录上限，未列出\n");
+    }
+}
+
+void StreamLexer::writeSymbolTable(OutputWriter& out) const {
+    lexer_.writeSymbolTable(out);
+}
+
+}
@@ -0,0 +1,87 @@
+#ifndef STREAM_LEXER_H
+#define STREAM_LEXER_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "lexer.h"
+
+namespace lexer {
+
+class OutputWriter;
+
+// 有界内存的流式词法分析：源码经固定大小的窗口分段读入（管道、标准输入、超大文件），
+// 每次在窗口内最后一个换行处切开，只分析这之前的部分，余下的移到下一个窗口开头。
+// 整个窗口没有换行时（压缩过的源码等）改在最后一个空白之后切开，空白不属于任何Token。
+// 窗口之间可能处于“正常”“多行注释内”或“单行注释内”三种状态：多行注释沿用分块扫描的
+// 延迟报错机制衔接，单行注释由下一个窗口先跳到换行处。行号、列号、符号表和错误计数贯穿
+// 整个输入；Token和错误的偏移相对当前窗口，须在读下一个窗口前处理完。内存占用为窗口大小
+// 加符号表，与输入总长无关；只有既无换行也无空白的片段才扩大窗口，超过kMaxWindowGrowth倍
+// 时抛出异常。结果与一次性分析整个输入逐字节一致
+class StreamLexer {
+public:
+    static constexpr size_t kDefaultWindow = 1 << 20;
+    // 无处可切的片段最多把窗口扩大到这么多倍
+    static constexpr size_t kMaxWindowGrowth = 64;
+    // 读入至多size字节到data，返回读到的字节数，0表示输入结束；出错时抛出异常
+    using ReadFunction = std::function<size_t(char* data, size_t size)>;
+    
+    // 打开path（"-"为标准输入）并返回按块读取它的函数，打不开时抛出异常
+    static ReadFunction openInput(const std::string& path);
+    
+    explicit StreamLexer(const std::string& path, size_t windowSize = kDefaultWindow);
+    // 从read读取输入，供流水线等自行组织读取的调用方使用
+    explicit StreamLexer(ReadFunction read, size_t windowSize = kDefaultWindow);
+    StreamLexer(const StreamLexer&) = delete;
+    StreamLexer& operator=(const StreamLexer&) = delete;
+    
+    // 读入并分析下一个窗口，输入已分析完时返回false。最后一个窗口的Token以EOF结尾
+    bool next();
+    std::string_view window() const;
+    const std::vector<Token>& tokens() const;
+    // 当前窗口记录下来的错误，已按错误上限截断
+    const std::vector<LexicalError>& errors() const;
+    
+    // 整个输入最多记录limit个错误（0表示不限），须在next()之前设置
+    void setErrorLimit(size_t limit);
+    // 以下均为截至当前窗口的累计值
+    size_t getTokenCount() const;
+    size_t getErrorCount() const;
+    size_t getBytesRead() const;
+    const SymbolTable& getSymbolTable() const;
+    
+    // 每个窗口之后调用，把该窗口的结果追加到输出；错误输出在最后一个窗口补上
+    // “无错误”或超出上限的提示，拼接后与Lexer::writeErrors相同。符号表在全部分析完后写出
+    void writeTokens(OutputWriter& out, bool symbolRefs = false) const;
+    void writeErrors(OutputWriter& out) const;
+    void writeSymbolTable(OutputWriter& out) const;
+
+private:
+    ReadFunction read_;
+    std::string buffer_;
+    size_t windowSize_;
+    size_t filled_;         // buffer_中已读入的字节数
+    size_t cut_;            // 当前窗口的长度，之后的字节留给下一个窗口
+    bool eof_;
+    bool done_;
+    size_t bytesRead_;
+    
+    Lexer lexer_;
+    int line_;              // 下一个窗口起点的行号
+    size_t lineCarry_;      // 上一个窗口在行中间切开时，该行已分析的字节数
+    bool commentOpen_;      // 上一个窗口结束在多行注释内
+    bool lineCommentOpen_;  // 上一个窗口结束在单行注释内
+    int openLine_;
+    int openColumn_;
+    size_t errorLimit_;
+    size_t recorded_;       // 之前各窗口记录的错误数
+    size_t tokenCount_;
+    
+    void fill();
+    void lexWindow();
+};
+
+}
+
+#endif
@@ -1,47 +1,230 @@
 #include "symbol_table.h"
 #include <algorithm>
+#include <cstring>
+#include <utility>
 
 namespace lexer {
 
-SymbolTable::SymbolTable() : nextId_(0) {}
+SymbolTable::SymbolTable(std::pmr::memory_resource* resource)
+    : resource_(resource), slots_(kInitialSlots, Slot{0, 0}), blocksUsed_(0), blockCursor_(nullptr),
+      blockRemaining_(0), arenaBytes_(0)
+#if LEXER_STATS
+      , inserts_(0), probes_(0), maxProbe_(0)
+#endif
+{
+}
+
+SymbolTable::~SymbolTable() {
+    releaseBlocks();
+}
+
+SymbolTable::SymbolTable(SymbolTable&& other) noexcept : SymbolTable(other.resource_) {
+    *this = std::move(other);
+}
 
-int SymbolTable::insert(const std::string& name) {
-    auto it = symbols_.find(name);
-    if (it != symbols_.end()) {
-        return it->second.id;
+// 内存块连同其来源的resource一起转移
+SymbolTable& SymbolTable::operator=(SymbolTable&& other) noexcept {
+    if(this != &other) {
+        releaseBlocks();
+        resource_ = other.resource_;
+        entries_ = std::move(other.entries_);
+        slots_ = std::move(other.slots_);
+        blocks_ = std::move(other.blocks_);
+        blocksUsed_ = other.blocksUsed_;
+        blockCursor_ = other.blockCursor_;
+        blockRemaining_ = other.blockRemaining_;
+        arenaBytes_ = other.arenaBytes_;
+        other.entries_.clear();
+        other.slots_.assign(kInitialSlots, Slot{0, 0});
+        other.blocks_.clear();
+        other.blocksUsed_ = 0;
+        other.blockCursor_ = nullptr;
+        other.blockRemaining_ = 0;
+        other.arenaBytes_ = 0;
+#if LEXER_STATS
+        inserts_ = other.inserts_;
+        probes_ = other.probes_;
+        maxProbe_ = other.maxProbe_;
+        other.inserts_ = other.probes_ = other.maxProbe_ = 0;
+#endif
     }
-    SymbolInfo info{nextId_, name};
-    symbols_[name] = info;
-    return nextId_++;
+    return *this;
 }
 
-const SymbolInfo* SymbolTable::lookup(const std::string& name) const {
-    auto it = symbols_.find(name);
-    if (it != symbols_.end()) {
-        return &(it->second);
+void SymbolTable::releaseBlocks() {
+    for(const Block& block : blocks_) {
+        resource_->deallocate(block.data, block.size, 1);
+    }
+    blocks_.clear();
+}
+
+// 每次吸收8字节的乘法散列，标识符通常只需要1~4轮
+std::uint64_t SymbolTable::hash(std::string_view name) {
+    const std::uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+    std::uint64_t h = name.size() * kMultiplier;
+    const char* p = name.data();
+    size_t remaining = name.size();
+    while(remaining >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, 8);
+        h = (h ^ word) * kMultiplier;
+        h ^= h >> 29;
+        p += 8;
+        remaining -= 8;
+    }
+    if(remaining > 0) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, p, remaining);
+        h = (h ^ word) * kMultiplier;
+        h ^= h >> 29;
+    }
+    h *= kMultiplier;
+    return h ^ (h >> 32);
+}
+
+size_t SymbolTable::findSlot(std::string_view name, std::uint64_t hash) const {
+    const size_t mask = slots_.size() - 1;
+    const std::uint32_t tag = static_cast<std::uint32_t>(hash >> 32);
+    size_t slot = static_cast<size_t>(hash) & mask;
+    for(;;) {
+        const Slot& candidate = slots_[slot];
+        if(candidate.index == 0) {
+            return slot;
+        }
+        if(candidate.tag == tag && entries_[candidate.index - 1].name == name) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+// 先按顺序复用clear()前留下的块，都放不下时再向resource申请新块
+void SymbolTable::nextBlock(size_t minSize) {
+    while(blocksUsed_ < blocks_.size() && blocks_[blocksUsed_].size < minSize) {
+        blocksUsed_++;
+    }
+    if(blocksUsed_ == blocks_.size()) {
+        size_t blockSize = minSize > kBlockSize ? minSize : kBlockSize;
+        blocks_.push_back(Block{static_cast<char*>(resource_->allocate(blockSize, 1)), blockSize});
+        arenaBytes_ += blockSize;
+    }
+    blockCursor_ = blocks_[blocksUsed_].data;
+    blockRemaining_ = blocks_[blocksUsed_].size;
+    blocksUsed_++;
+}
+
+std::string_view SymbolTable::store(std::string_view name) {
+    if(name.size() > blockRemaining_) {
+        nextBlock(name.size());
+    }
+    if(!name.empty()) {
+        std::memcpy(blockCursor_, name.data(), name.size());
+    }
+    std::string_view stored(blockCursor_, name.size());
+    blockCursor_ += name.size();
+    blockRemaining_ -= name.size();
+    return stored;
+}
+
+// 装载因子超过1/2时容量翻倍，重新散列放置全部条目
+void SymbolTable::grow() {
+    std::vector<Slot> old(slots_.size() * 2, Slot{0, 0});
+    old.swap(slots_);
+    const size_t mask = slots_.size() - 1;
+    for(const Slot& entry : old) {
+        if(entry.index == 0) {
+            continue;
+        }
+        std::uint64_t h = hash(entries_[entry.index - 1].name);
+        size_t slot = static_cast<size_t>(h) & mask;
+        while(slots_[slot].index != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = entry;
     }
-    return nullptr;
 }
 
-std::vector<SymbolInfo> SymbolTable::getAllSymbols() const {
-    std::vector<SymbolInfo> result;
-    result.reserve(symbols_.size());
-    for (const auto& pair : symbols_) {
-        result.push_back(pair.second);
+int SymbolTable::insert(std::string_view name) {
+    return insert(name, hash(name));
+}
+
+int SymbolTable::insert(std::string_view name, std::uint64_t hash) {
+    size_t slot = findSlot(name, hash);
+#if LEXER_STATS
+    // 线性探测的探查次数等于到散列起点的距离加1
+    std::uint64_t probes = ((slot - static_cast<size_t>(hash)) & (slots_.size() - 1)) + 1;
+    inserts_++;
+    probes_ += probes;
+    maxProbe_ = probes > maxProbe_ ? probes : maxProbe_;
+#endif
+    if(slots_[slot].index != 0) {
+        return entries_[slots_[slot].index - 1].id;
+    }
+    int id = static_cast<int>(entries_.size());
+    entries_.push_back(SymbolInfo{id, store(name)});
+    slots_[slot] = Slot{static_cast<std::uint32_t>(entries_.size()),
+                        static_cast<std::uint32_t>(hash >> 32)};
+    if(entries_.size() * 2 > slots_.size()) {
+        grow();
     }
-    std::sort(result.begin(), result.end(), 
-              [](const SymbolInfo& a, const SymbolInfo& b) {
-                  return a.id < b.id;
-              });
-    return result;
+    return id;
+}
+
+const SymbolInfo* SymbolTable::lookup(std::string_view name) const {
+    size_t slot = findSlot(name, hash(name));
+    if(slots_[slot].index != 0) {
+        return &entries_[slots_[slot].index - 1];
+    }
+    return nullptr;
+}
+
+const std::vector<SymbolInfo>& SymbolTable::getAllSymbols() const {
+    return entries_;
 }
 
 size_t SymbolTable::size() const {
-    return symbols_.size();
+    return entries_.size();
+}
+
+bool SymbolTable::contains(std::string_view name) const {
+    return lookup(name) != nullptr;
+}
+
+void SymbolTable::clear() {
+    if(entries_.size() * 8 < slots_.size()) {
+        // 索引远大于条目数（之前处理过大文件）时只清掉占用的槽位；槽位中记录的下标
+        // 唯一确定了条目，沿探测序列找到它即可，不受已清空槽位的影响
+        const size_t mask = slots_.size() - 1;
+        for(const auto& entry : entries_) {
+            size_t slot = static_cast<size_t>(hash(entry.name)) & mask;
+            while(slots_[slot].index != static_cast<std::uint32_t>(entry.id) + 1) {
+                slot = (slot + 1) & mask;
+            }
+            slots_[slot] = Slot{0, 0};
+        }
+    } else {
+        std::fill(slots_.begin(), slots_.end(), Slot{0, 0});
+    }
+    entries_.clear();
+    blocksUsed_ = 0;
+    blockCursor_ = nullptr;
+    blockRemaining_ = 0;
+#if LEXER_STATS
+    inserts_ = probes_ = maxProbe_ = 0;
+#endif
 }
 
-bool SymbolTable::contains(const std::string& name) const {
-    return symbols_.find(name) != symbols_.end();
+SymbolTableStats SymbolTable::getStats() const {
+    SymbolTableStats stats;
+    stats.symbols = entries_.size();
+    stats.slots = slots_.size();
+    stats.arenaBytes = arenaBytes_;
+#if LEXER_STATS
+    stats.inserts = inserts_;
+    stats.probes = probes_;
+    stats.maxProbe = maxProbe_;
+#endif
+    return stats;
 }
 
 }
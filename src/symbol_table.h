@@ -1,29 +1,89 @@
 #ifndef SYMBOL_TABLE_H
 #define SYMBOL_TABLE_H
 
-#include <string>
-#include <unordered_map>
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
 #include <vector>
+#include "lexer_stats.h"
 
 namespace lexer {
 
 struct SymbolInfo {
     int id;
-    std::string name;
+    std::string_view name;      // 指向符号表自己的内存块，随符号表存活
 };
 
+// 符号表的负载与探测统计；未启用LEXER_STATS时inserts、probes、maxProbe恒为0
+struct SymbolTableStats {
+    size_t symbols = 0;
+    size_t slots = 0;
+    size_t arenaBytes = 0;
+    std::uint64_t inserts = 0;
+    std::uint64_t probes = 0;       // 插入时探查的槽位总数，理想情况等于inserts
+    std::uint64_t maxProbe = 0;
+};
+
+// 字符串驻留表：名字只在按块分配的内存里存一份，条目按id顺序稠密存放，
+// 开放寻址（线性探测）的索引只记录条目下标和散列值。内存块取自resource，
+// clear()后保留下来供下一批名字复用
 class SymbolTable {
 public:
-    SymbolTable();
-    int insert(const std::string& name);
-    const SymbolInfo* lookup(const std::string& name) const;
-    std::vector<SymbolInfo> getAllSymbols() const;
+    explicit SymbolTable(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    ~SymbolTable();
+    SymbolTable(SymbolTable&& other) noexcept;
+    SymbolTable& operator=(SymbolTable&& other) noexcept;
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+    
+    static std::uint64_t hash(std::string_view name);
+    
+    int insert(std::string_view name);
+    // 调用方已算好散列值时使用，省去重复计算
+    int insert(std::string_view name, std::uint64_t hash);
+    const SymbolInfo* lookup(std::string_view name) const;
+    // 按id（即首次出现顺序）排列的全部符号，无需排序
+    const std::vector<SymbolInfo>& getAllSymbols() const;
     size_t size() const;
-    bool contains(const std::string& name) const;
+    bool contains(std::string_view name) const;
+    SymbolTableStats getStats() const;
+    // 清空全部符号，保留索引容量和内存块
+    void clear();
     
 private:
-    std::unordered_map<std::string, SymbolInfo> symbols_;
-    int nextId_;
+    struct Slot {
+        std::uint32_t index;    // 条目下标加1，0表示空槽
+        std::uint32_t tag;      // 散列值的高32位，用于快速排除不等的名字
+    };
+    
+    struct Block {
+        char* data;
+        size_t size;
+    };
+    
+    static constexpr size_t kBlockSize = 64 * 1024;
+    static constexpr size_t kInitialSlots = 64;
+    
+    std::pmr::memory_resource* resource_;
+    std::vector<SymbolInfo> entries_;
+    std::vector<Slot> slots_;
+    std::vector<Block> blocks_;
+    size_t blocksUsed_;         // blocks_中已用于当前内容的块数
+    char* blockCursor_;
+    size_t blockRemaining_;
+    size_t arenaBytes_;
+#if LEXER_STATS
+    // 只在insert中计数：const的lookup可被多个线程并发调用
+    std::uint64_t inserts_;
+    std::uint64_t probes_;
+    std::uint64_t maxProbe_;
+#endif
+    
+    size_t findSlot(std::string_view name, std::uint64_t hash) const;
+    std::string_view store(std::string_view name);
+    void nextBlock(size_t minSize);
+    void releaseBlocks();
+    void grow();
 };
 
 }
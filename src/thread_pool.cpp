@@ -0,0 +1,116 @@
+#include "thread_pool.h"
+
+namespace lexer {
+
+namespace {
+
+// 当前线程所属的线程池及其队列下标，外部线程为nullptr
+thread_local const void* currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+
+}
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : queued_(0), unfinished_(0), nextQueue_(0), stopping_(false) {
+    if(threadCount == 0) {
+        threadCount = 1;
+    }
+    for(size_t i = 0; i < threadCount; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for(size_t i = 0; i < threadCount; ++i) {
+        threads_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for(auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task) {
+    // std::function要求可拷贝，packaged_task只能移动，因此经shared_ptr持有
+    auto packaged = std::make_shared<std::packaged_task<void()>>(std::move(task));
+    std::future<void> result = packaged->get_future();
+    size_t target;
+    {
+        // queued_先于入队递增，取任务时的递减不会使其下溢
+        std::lock_guard<std::mutex> lock(mutex_);
+        unfinished_++;
+        queued_++;
+        if(currentPool == this) {
+            target = currentIndex;
+        } else {
+            target = nextQueue_;
+            nextQueue_ = (nextQueue_ + 1) % queues_.size();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back([packaged]() { (*packaged)(); });
+    }
+    workAvailable_.notify_one();
+    return result;
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    allDone_.wait(lock, [this]() { return unfinished_ == 0; });
+}
+
+size_t ThreadPool::size() const {
+    return threads_.size();
+}
+
+bool ThreadPool::take(size_t self, std::function<void()>& task) {
+    {
+        Queue& own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if(!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for(size_t offset = 1; offset < queues_.size(); ++offset) {
+        Queue& victim = *queues_[(self + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    currentPool = this;
+    currentIndex = self;
+    for(;;) {
+        std::function<void()> task;
+        if(take(self, task)) {
+            queued_--;
+            task();
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(--unfinished_ == 0) {
+                allDone_.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        workAvailable_.wait(lock, [this]() { return stopping_ || queued_ > 0; });
+        if(stopping_ && queued_ == 0) {
+            return;
+        }
+    }
+}
+
+}
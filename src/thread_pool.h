@@ -0,0 +1,54 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lexer {
+
+// 工作窃取线程池：每个工作线程有自己的双端队列，从队尾取自己的任务，
+// 空闲时从其他线程的队首窃取
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    // 工作线程内提交的任务进入本线程队列，外部提交的任务轮流分发。
+    // 任务抛出的异常不会终止工作线程，而是存入返回的future，由提交方get()时重新抛出
+    std::future<void> submit(std::function<void()> task);
+    // 阻塞直到已提交的任务全部完成
+    void wait();
+    size_t size() const;
+    
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+    
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable allDone_;
+    std::atomic<size_t> queued_;        // 已入队尚未被取走的任务数
+    size_t unfinished_;                 // 已提交尚未完成的任务数，受mutex_保护
+    size_t nextQueue_;
+    bool stopping_;
+    
+    bool take(size_t self, std::function<void()>& task);
+    void workerLoop(size_t self);
+};
+
+}
+
+#endif
@@ -0,0 +1,246 @@
+#include "token_stream.h"
+#include "lexer.h"
+#include "output_writer.h"
+#include "symbol_table.h"
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace lexer {
+
+namespace {
+
+std::uint64_t alignUp(std::uint64_t value) {
+    return (value + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+template <typename Record>
+void appendRecord(OutputWriter& out, const Record& record) {
+    out.append(std::string_view(reinterpret_cast<const char*>(&record), sizeof(record)));
+}
+
+void appendPadding(OutputWriter& out, std::uint64_t written) {
+    for(std::uint64_t i = written; i < alignUp(written); ++i) {
+        out.append('\0');
+    }
+}
+
+std::uint32_t toIndex(int id) {
+    return static_cast<std::uint32_t>(id);
+}
+
+}
+
+template <unsigned Features>
+void writeTokenStream(const BasicLexer<Features>& lexer, const std::string& filepath) {
+    static_assert(BasicLexer<Features>::kKeepsTokens && BasicLexer<Features>::kInternsSymbols &&
+                  BasicLexer<Features>::kCollectsErrors, "二进制Token流需要完整的Token、符号表和错误");
+    const auto& tokens = lexer.getTokens();
+    const auto& errors = lexer.getErrors();
+    const auto& symbols = lexer.getSymbolTable().getAllSymbols();
+    std::string_view source = lexer.getSource();
+    
+    // 第一遍：驻留全部文本，确定字符串下标与池大小。符号名按id顺序最先驻留，
+    // 标识符Token直接用其符号id作下标，不必再按名字驻留
+    SymbolTable strings;
+    std::vector<std::uint32_t> symbolText;
+    symbolText.reserve(symbols.size());
+    for(const auto& symbol : symbols) {
+        symbolText.push_back(toIndex(strings.insert(symbol.name)));
+    }
+    std::vector<std::uint32_t> tokenText;
+    tokenText.reserve(tokens.size());
+    for(const auto& token : tokens) {
+        int id = token.getType() == TokenType::IDENTIFIER ? lexer.symbolId(token) : -1;
+        tokenText.push_back(toIndex(id >= 0 ? id : strings.insert(token.getValue(source))));
+    }
+    std::vector<std::uint32_t> errorText;
+    errorText.reserve(errors.size());
+    for(const auto& error : errors) {
+        errorText.push_back(toIndex(strings.insert(error.getMessage(source))));
+    }
+    const auto& pooled = strings.getAllSymbols();
+    
+    std::uint64_t poolSize = 0;
+    for(const auto& entry : pooled) {
+        poolSize += entry.name.size();
+    }
+    if(poolSize > UINT32_MAX) {
+        throw std::length_error("字符串池超过4GiB: " + filepath);
+    }
+    
+    binary::Header header{};
+    std::memcpy(header.magic, binary::kMagic, sizeof(header.magic));
+    header.byteOrder = binary::kByteOrderMark;
+    header.version = binary::kVersion;
+    header.headerSize = sizeof(binary::Header);
+    header.tokenOffset = sizeof(binary::Header);
+    header.tokenCount = tokens.size();
+    header.stringOffset = alignUp(header.tokenOffset + tokens.size() * sizeof(binary::TokenRecord));
+    header.stringCount = pooled.size();
+    header.symbolOffset = alignUp(header.stringOffset + pooled.size() * sizeof(binary::StringRef));
+    header.symbolCount = symbols.size();
+    header.errorOffset = alignUp(header.symbolOffset + symbols.size() * sizeof(binary::SymbolRecord));
+    header.errorCount = errors.size();
+    header.poolOffset = alignUp(header.errorOffset + errors.size() * sizeof(binary::ErrorRecord));
+    header.poolSize = poolSize;
+    
+    // 第二遍：按段顺序写出
+    // 扫描时未维护行号的Token在这里按偏移换算，Token偏移递增，用游标顺序前移即可
+    OutputWriter out(filepath);
+    appendRecord(out, header);
+    constexpr bool resolve = !BasicLexer<Features>::kTracksPositions;
+    std::optional<LineIndex::Cursor> cursor;
+    if constexpr(resolve) {
+        cursor.emplace(lexer.getLineIndex());
+    }
+    for(size_t i = 0; i < tokens.size(); ++i) {
+        const Token& token = tokens[i];
+        SourcePosition position = resolve ? cursor->locate(token.getOffset())
+                                          : SourcePosition{token.getLine(), token.getColumn()};
+        appendRecord(out, binary::TokenRecord{token.getCategoryCode(),
+                                              static_cast<std::uint32_t>(position.line),
+                                              static_cast<std::uint32_t>(position.column),
+                                              tokenText[i]});
+    }
+    appendPadding(out, tokens.size() * sizeof(binary::TokenRecord));
+    
+    std::uint32_t offset = 0;
+    for(const auto& entry : pooled) {
+        appendRecord(out, binary::StringRef{offset, static_cast<std::uint32_t>(entry.name.size())});
+        offset += static_cast<std::uint32_t>(entry.name.size());
+    }
+    appendPadding(out, pooled.size() * sizeof(binary::StringRef));
+    
+    for(std::uint32_t name : symbolText) {
+        appendRecord(out, binary::SymbolRecord{name});
+    }
+    appendPadding(out, symbols.size() * sizeof(binary::SymbolRecord));
+    
+    for(size_t i = 0; i < errors.size(); ++i) {
+        appendRecord(out, binary::ErrorRecord{static_cast<std::uint32_t>(errors[i].getLine()),
+                                              static_cast<std::uint32_t>(errors[i].getColumn()),
+                                              errorText[i],
+                                              static_cast<std::uint32_t>(errors[i].getCode()),
+                                              static_cast<std::uint32_t>(errors[i].getOffset()),
+                                              static_cast<std::uint32_t>(errors[i].getLength())});
+    }
+    appendPadding(out, errors.size() * sizeof(binary::ErrorRecord));
+    
+    for(const auto& entry : pooled) {
+        out.append(entry.name);
+    }
+    out.close();
+}
+
+template void writeTokenStream(const BasicLexer<kAllFeatures & ~kTrackPositions>&, const std::string&);
+template void writeTokenStream(const Lexer&, const std::string&);
+
+TokenStreamReader::TokenStreamReader(const std::string& filepath) : file_(filepath) {
+    std::string_view data = file_.view();
+    if(data.size() < sizeof(binary::Header)) {
+        throw std::runtime_error("不是有效的二进制Token流: " + filepath);
+    }
+    std::memcpy(&header_, data.data(), sizeof(header_));
+    if(std::memcmp(header_.magic, binary::kMagic, sizeof(header_.magic)) != 0 ||
+       header_.headerSize != sizeof(binary::Header)) {
+        throw std::runtime_error("不是有效的二进制Token流: " + filepath);
+    }
+    if(header_.byteOrder != binary::kByteOrderMark) {
+        throw std::runtime_error("二进制Token流的字节序与本机不同或版本过旧: " + filepath);
+    }
+    if(header_.version != binary::kVersion) {
+        throw std::runtime_error("不支持的二进制Token流版本: " + filepath);
+    }
+    
+    auto section = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t size) {
+        if(offset % 8 != 0 || offset > data.size() || count > (data.size() - offset) / size) {
+            throw std::runtime_error("二进制Token流已损坏: " + filepath);
+        }
+        return data.data() + offset;
+    };
+    tokens_ = reinterpret_cast<const binary::TokenRecord*>(
+        section(header_.tokenOffset, header_.tokenCount, sizeof(binary::TokenRecord)));
+    strings_ = reinterpret_cast<const binary::StringRef*>(
+        section(header_.stringOffset, header_.stringCount, sizeof(binary::StringRef)));
+    symbols_ = reinterpret_cast<const binary::SymbolRecord*>(
+        section(header_.symbolOffset, header_.symbolCount, sizeof(binary::SymbolRecord)));
+    errors_ = reinterpret_cast<const binary::ErrorRecord*>(
+        section(header_.errorOffset, header_.errorCount, sizeof(binary::ErrorRecord)));
+    pool_ = section(header_.poolOffset, header_.poolSize, 1);
+    
+    // 一次性校验全部下标，之后的访问无需再检查
+    for(std::uint64_t i = 0; i < header_.stringCount; ++i) {
+        if(strings_[i].offset > header_.poolSize ||
+           strings_[i].length > header_.poolSize - strings_[i].offset) {
+            throw std::runtime_error("二进制Token流已损坏: " + filepath);
+        }
+    }
+    auto checkIndex = [&](std::uint32_t index) {
+        if(index >= header_.stringCount) {
+            throw std::runtime_error("二进制Token流已损坏: " + filepath);
+        }
+    };
+    for(std::uint64_t i = 0; i < header_.tokenCount; ++i) {
+        checkIndex(tokens_[i].text);
+        if(tokens_[i].code == static_cast<std::int32_t>(TokenType::IDENTIFIER) &&
+           tokens_[i].text >= header_.symbolCount) {
+            throw std::runtime_error("二进制Token流已损坏: " + filepath);
+        }
+    }
+    for(std::uint64_t i = 0; i < header_.symbolCount; ++i) {
+        if(symbols_[i].name != i) {
+            throw std::runtime_error("二进制Token流已损坏: " + filepath);
+        }
+    }
+    for(std::uint64_t i = 0; i < header_.errorCount; ++i) {
+        checkIndex(errors_[i].message);
+    }
+}
+
+const binary::TokenRecord* TokenStreamReader::begin() const {
+    return tokens_;
+}
+
+const binary::TokenRecord* TokenStreamReader::end() const {
+    return tokens_ + header_.tokenCount;
+}
+
+size_t TokenStreamReader::tokenCount() const {
+    return static_cast<size_t>(header_.tokenCount);
+}
+
+std::string_view TokenStreamReader::text(const binary::TokenRecord& token) const {
+    return string(token.text);
+}
+
+int TokenStreamReader::symbolId(const binary::TokenRecord& token) const {
+    return token.code == static_cast<std::int32_t>(TokenType::IDENTIFIER) ? static_cast<int>(token.text) : -1;
+}
+
+size_t TokenStreamReader::symbolCount() const {
+    return static_cast<size_t>(header_.symbolCount);
+}
+
+std::string_view TokenStreamReader::symbol(size_t id) const {
+    return string(symbols_[id].name);
+}
+
+size_t TokenStreamReader::errorCount() const {
+    return static_cast<size_t>(header_.errorCount);
+}
+
+const binary::ErrorRecord& TokenStreamReader::error(size_t index) const {
+    return errors_[index];
+}
+
+std::string_view TokenStreamReader::message(const binary::ErrorRecord& error) const {
+    return string(error.message);
+}
+
+std::string_view TokenStreamReader::string(std::uint32_t index) const {
+    return std::string_view(pool_ + strings_[index].offset, strings_[index].length);
+}
+
+}
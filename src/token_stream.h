@@ -0,0 +1,110 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "lexer_features.h"
+#include "source_file.h"
+
+namespace lexer {
+
+// 二进制Token流格式（写入方的本机字节序，各段按8字节对齐）：
+//   文件头 | Token记录数组 | 字符串引用数组 | 符号数组 | 错误记录数组 | 字符串池
+// Token的属性值、符号名和错误信息都以字符串引用的下标表示，相同文本只在池中存一份。
+// 符号名最先驻留，因此符号id即其名字的字符串下标，标识符Token的属性值下标就是符号id。
+// 记录不经转换直接映射使用，文件头的byteOrder为本机写出的kByteOrderMark，字节序不同的机器拒绝读取
+namespace binary {
+
+constexpr char kMagic[8] = {'C', 'L', 'E', 'X', 'T', 'O', 'K', '\0'};
+constexpr std::uint32_t kVersion = 3;
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+struct Header {
+    char magic[8];
+    std::uint32_t byteOrder;
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t reserved;
+    std::uint64_t tokenOffset;
+    std::uint64_t tokenCount;
+    std::uint64_t stringOffset;
+    std::uint64_t stringCount;
+    std::uint64_t symbolOffset;
+    std::uint64_t symbolCount;
+    std::uint64_t errorOffset;
+    std::uint64_t errorCount;
+    std::uint64_t poolOffset;
+    std::uint64_t poolSize;
+};
+
+struct TokenRecord {
+    std::int32_t code;          // TokenType类别码
+    std::uint32_t line;
+    std::uint32_t column;
+    std::uint32_t text;         // 属性值的字符串下标，标识符的即为符号id
+};
+
+struct StringRef {
+    std::uint32_t offset;       // 相对字符串池起点
+    std::uint32_t length;
+};
+
+struct SymbolRecord {
+    std::uint32_t name;         // 符号名的字符串下标，数组下标即符号id
+};
+
+struct ErrorRecord {
+    std::uint32_t line;
+    std::uint32_t column;
+    std::uint32_t message;      // 错误信息的字符串下标
+    std::uint32_t code;         // ErrorCode
+    std::uint32_t offset;       // 出错的源码区间，未闭合注释的为注释起点、长度为0
+    std::uint32_t length;
+};
+
+static_assert(sizeof(Header) == 104, "二进制文件头布局有误");
+static_assert(sizeof(TokenRecord) == 16, "Token记录布局有误");
+static_assert(sizeof(ErrorRecord) == 24, "错误记录布局有误");
+
+}
+
+// 把lexer已物化的Token、符号表和错误写成二进制Token流。只为保留Token、登记符号且记录错误的
+// 实例提供（见token_stream.cpp末尾的显式实例化）
+template <unsigned Features>
+void writeTokenStream(const BasicLexer<Features>& lexer, const std::string& filepath);
+
+// 二进制Token流读取器：mmap映射文件并校验各段边界，之后的访问都不拷贝
+class TokenStreamReader {
+public:
+    explicit TokenStreamReader(const std::string& filepath);
+    
+    const binary::TokenRecord* begin() const;
+    const binary::TokenRecord* end() const;
+    size_t tokenCount() const;
+    std::string_view text(const binary::TokenRecord& token) const;
+    // 标识符Token的符号id，其余Token为-1
+    int symbolId(const binary::TokenRecord& token) const;
+    
+    size_t symbolCount() const;
+    std::string_view symbol(size_t id) const;
+    
+    size_t errorCount() const;
+    const binary::ErrorRecord& error(size_t index) const;
+    std::string_view message(const binary::ErrorRecord& error) const;
+    
+    std::string_view string(std::uint32_t index) const;
+
+private:
+    SourceFile file_;
+    binary::Header header_;
+    const binary::TokenRecord* tokens_;
+    const binary::StringRef* strings_;
+    const binary::SymbolRecord* symbols_;
+    const binary::ErrorRecord* errors_;
+    const char* pool_;
+};
+
+}
+
+#endif
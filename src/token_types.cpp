@@ -1,35 +1,87 @@
 #include "token_types.h"
 #include <sstream>
+#include "char_class.h"
 
 namespace lexer {
 
-Token::Token(TokenType type, const std::string& value, int line, int column)
-    : type_(type), value_(value), line_(line), column_(column) {
+Token::Token(TokenType type, size_t offset, size_t length, int line, int column)
+    : offset_(static_cast<std::uint32_t>(offset)),
+      info_(static_cast<std::uint8_t>(type) |
+            (static_cast<std::uint32_t>(length < kLongLength ? length : kLongLength) << 8)),
+      line_(static_cast<std::uint32_t>(line)),
+      column_(static_cast<std::uint32_t>(column)) {
+}
+
+Token Token::identifier(size_t offset, int symbolId, int line, int column) {
+    Token token(TokenType::IDENTIFIER, offset, 0, line, column);
+    return token.withSymbolId(symbolId);
 }
 
 TokenType Token::getType() const {
-    return type_;
+    return static_cast<TokenType>(static_cast<std::int8_t>(info_ & 0xFF));
 }
 
-std::string Token::getValue() const {
-    return value_;
+std::string_view Token::getValue(std::string_view source) const {
+    size_t length = info_ >> 8;
+    if(getType() == TokenType::IDENTIFIER) {
+        length = 0;
+        while(length < kMaxIdentifierLength && offset_ + length < source.size() &&
+              isIdentChar(source[offset_ + length])) {
+            length++;
+        }
+    } else if(length == kLongLength) {
+        length = 0;
+        while(offset_ + length < source.size() &&
+              source[offset_ + length] >= '0' && source[offset_ + length] <= '9') {
+            length++;
+        }
+    }
+    return source.substr(offset_, length);
+}
+
+size_t Token::getOffset() const {
+    return offset_;
 }
 
 int Token::getLine() const {
-    return line_;
+    return static_cast<int>(line_);
 }
 
 int Token::getColumn() const {
-    return column_;
+    return static_cast<int>(column_);
 }
 
 int Token::getCategoryCode() const {
-    return static_cast<int>(type_);
+    return static_cast<int>(getType());
+}
+
+Token Token::shifted(std::ptrdiff_t offsetDelta, int lineDelta, int columnDelta) const {
+    Token result = *this;
+    result.offset_ = static_cast<std::uint32_t>(static_cast<std::ptrdiff_t>(offset_) + offsetDelta);
+    result.line_ = static_cast<std::uint32_t>(static_cast<int>(line_) + lineDelta);
+    result.column_ = static_cast<std::uint32_t>(static_cast<int>(column_) + columnDelta);
+    return result;
+}
+
+int Token::getSymbolId() const {
+    std::uint32_t id = info_ >> 8;
+    if(getType() != TokenType::IDENTIFIER || id == kNoSymbol) {
+        return -1;
+    }
+    return static_cast<int>(id);
+}
+
+Token Token::withSymbolId(int symbolId) const {
+    Token result = *this;
+    std::uint32_t id = symbolId < 0 || static_cast<std::uint32_t>(symbolId) >= kNoSymbol
+                           ? kNoSymbol : static_cast<std::uint32_t>(symbolId);
+    result.info_ = (info_ & 0xFF) | (id << 8);
+    return result;
 }
 
-std::string Token::toString() const {
+std::string Token::toString(std::string_view source) const {
     std::ostringstream oss;
-    oss << "Token(" << getCategoryCode() << ", '" << value_ 
+    oss << "Token(" << getCategoryCode() << ", '" << getValue(source) 
         << "', " << line_ << ":" << column_ << ")";
     return oss.str();
 }
@@ -1,11 +1,14 @@
 #ifndef TOKEN_TYPES_H
 #define TOKEN_TYPES_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace lexer {
 
-enum class TokenType {
+enum class TokenType : std::int8_t {
     // 保留字
     VOID = 1,
     INT = 2,
@@ -56,24 +59,50 @@ enum class TokenType {
     ERROR = -1
 };
 
+// 类别码范围为-1~99，按类别码计数时以类别码加1为下标
+constexpr size_t kCategorySlots = 101;
+
+// 紧凑的Token表示（16字节）：不持有文本，只记录其在源码缓冲区中的偏移和长度，
+// 文本通过getValue(source)以string_view的形式取回。标识符不记长度而记符号id，
+// 使用方按整数比较标识符即可，不必取回文本
 class Token {
 public:
-    Token(TokenType type, const std::string& value, int line, int column);
+    // 构造标识符以外的Token，标识符用identifier
+    Token(TokenType type, size_t offset, size_t length, int line, int column);
+    // symbolId为-1表示未登记符号
+    static Token identifier(size_t offset, int symbolId, int line, int column);
     
     TokenType getType() const;
-    std::string getValue() const;
+    std::string_view getValue(std::string_view source) const;
+    size_t getOffset() const;
     int getLine() const;
     int getColumn() const;
     int getCategoryCode() const;
-    std::string toString() const;
-    
+    std::string toString(std::string_view source) const;
+    // 平移位置后的副本，供增量分析调整编辑点之后未变化的Token
+    Token shifted(std::ptrdiff_t offsetDelta, int lineDelta, int columnDelta) const;
+    // 标识符的符号id；不是标识符、未登记或id超出24位时为-1，后者须按名字到符号表中查找
+    int getSymbolId() const;
+    // 换成另一个符号id的副本，供合并多个符号表时重新编号
+    Token withSymbolId(int symbolId) const;
+
 private:
-    TokenType type_;
-    std::string value_;
-    int line_;
-    int column_;
+    // 长度字段只有24位；超长的整数常量记为kLongLength，
+    // 取值时从偏移处重新扫描连续数字得到实际长度
+    static constexpr std::uint32_t kLongLength = 0xFFFFFF;
+    // 标识符的长度字段存符号id，kNoSymbol表示没有可用的id。
+    // 标识符的长度不超过32，取值时从偏移处重新扫描得到
+    static constexpr std::uint32_t kNoSymbol = 0xFFFFFF;
+    static constexpr size_t kMaxIdentifierLength = 32;
+    
+    std::uint32_t offset_;
+    std::uint32_t info_;    // 低8位为类型，高24位为长度（标识符为符号id）
+    std::uint32_t line_;
+    std::uint32_t column_;
 };
 
+static_assert(sizeof(Token) == 16, "Token应保持16字节");
+
 }
 
 #endif
@@ -0,0 +1,64 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lexer {
+namespace utf8 {
+
+// 从一个非ASCII字节开始的编码：合法时length为整个编码的字节数；否则为最大无效子序列
+// （能作为某个合法编码开头的最长前缀）的字节数，至少为1，与Unicode建议的替换方式一致
+struct Sequence {
+    size_t length;
+    bool valid;
+};
+
+// 首字节之后第二个字节的合法区间，排除过长编码、代理区和超出U+10FFFF的码点
+inline bool secondByteValid(std::uint8_t lead, std::uint8_t second) {
+    switch(lead) {
+    case 0xE0: return second >= 0xA0 && second <= 0xBF;
+    case 0xED: return second >= 0x80 && second <= 0x9F;
+    case 0xF0: return second >= 0x90 && second <= 0xBF;
+    case 0xF4: return second >= 0x80 && second <= 0x8F;
+    default: return second >= 0x80 && second <= 0xBF;
+    }
+}
+
+// 合法首字节对应的编码长度，其余字节（续字节、C0/C1、F5及以上）为0
+inline size_t sequenceLength(std::uint8_t lead) {
+    if(lead >= 0xC2 && lead <= 0xDF) {
+        return 2;
+    }
+    if(lead >= 0xE0 && lead <= 0xEF) {
+        return 3;
+    }
+    if(lead >= 0xF0 && lead <= 0xF4) {
+        return 4;
+    }
+    return 0;
+}
+
+inline Sequence decode(const char* p, const char* end) {
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(p);
+    size_t expected = sequenceLength(bytes[0]);
+    if(expected == 0) {
+        return {1, false};
+    }
+    size_t available = static_cast<size_t>(end - p);
+    for(size_t i = 1; i < expected; ++i) {
+        if(i >= available) {
+            return {i, false};
+        }
+        bool ok = i == 1 ? secondByteValid(bytes[0], bytes[1]) : (bytes[i] & 0xC0) == 0x80;
+        if(!ok) {
+            return {i, false};
+        }
+    }
+    return {expected, true};
+}
+
+}
+}
+
+#endif
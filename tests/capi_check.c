@@ -0,0 +1,172 @@
+/* C接口检查：以C99编译并链接lexer_core，确认头文件在C中可用，
+ * 并核对会话复用、成批取Token、符号id、错误读取与各错误码 */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "lexer_capi.h"
+
+static int failures = 0;
+
+static void fail(const char* what) {
+    fprintf(stderr, "%s\n", what);
+    failures++;
+}
+
+static int sameText(const char* source, const lexer_token* token, const char* expected) {
+    return token->length == strlen(expected) && memcmp(source + token->offset, expected, token->length) == 0;
+}
+
+/* 以很小的批取完全部Token，返回个数；symbols可为NULL */
+static size_t drain(lexer_session* session, lexer_token* tokens, int32_t* symbols, size_t capacity) {
+    size_t total = 0;
+    size_t count = 0;
+    while(total < capacity) {
+        size_t batch = capacity - total < 3 ? capacity - total : 3;
+        if(lexer_next_tokens_with_symbols(session, tokens + total, symbols ? symbols + total : NULL, batch, &count) !=
+           LEXER_OK) {
+            fail("lexer_next_tokens_with_symbols返回错误");
+            return total;
+        }
+        if(count == 0) {
+            break;
+        }
+        total += count;
+    }
+    return total;
+}
+
+static void checkTokens(lexer_session* session) {
+    static const char source[] = "int x = 10;\nx = x + y;\n";
+    lexer_token tokens[32];
+    int32_t symbols[32];
+    size_t count;
+    size_t length = 0;
+    const char* name;
+    
+    if(lexer_reset(session, source, sizeof source - 1) != LEXER_OK) {
+        fail("lexer_reset失败");
+        return;
+    }
+    count = drain(session, tokens, symbols, 32);
+    if(count != 12 || tokens[count - 1].category != 99) {
+        fail("Token数不对或最后一个不是EOF");
+        return;
+    }
+    if(tokens[0].category != 2 || !sameText(source, &tokens[0], "int") || tokens[0].line != 1 ||
+       tokens[0].column != 1) {
+        fail("第一个Token不对");
+    }
+    if(tokens[1].category != 21 || !sameText(source, &tokens[1], "x") || tokens[1].column != 5) {
+        fail("标识符Token不对");
+    }
+    if(tokens[5].line != 2 || tokens[5].column != 1 || !sameText(source, &tokens[5], "x")) {
+        fail("第二行的行列号不对");
+    }
+    /* x的id为0，y的id为1，非标识符为-1 */
+    if(symbols[0] != -1 || symbols[1] != 0 || symbols[5] != 0 || symbols[9] != 1 || symbols[11] != -1) {
+        fail("符号id不对");
+    }
+    if(lexer_symbol_count(session) != 2) {
+        fail("符号数不对");
+        return;
+    }
+    name = lexer_symbol_name(session, 1, &length);
+    if(!name || length != 1 || name[0] != 'y') {
+        fail("符号名不对");
+    }
+    if(lexer_symbol_name(session, 0, NULL) == NULL || lexer_symbol_name(session, 2, &length) != NULL) {
+        fail("lexer_symbol_name对NULL长度或越界的id处理不对");
+    }
+    if(lexer_error_count(session) != 0) {
+        fail("不应有错误");
+    }
+    /* 取完EOF之后不再交出Token */
+    if(lexer_next_tokens(session, tokens, 32, &count) != LEXER_OK || count != 0) {
+        fail("EOF之后仍交出Token");
+    }
+}
+
+static void checkErrors(lexer_session* session) {
+    static const char source[] = "a @ b;\n$ /* 未闭合";
+    lexer_token tokens[32];
+    lexer_error error;
+    char buffer[8];
+    size_t full;
+    
+    lexer_set_error_limit(session, 2);
+    if(lexer_reset(session, source, sizeof source - 1) != LEXER_OK) {
+        fail("lexer_reset失败");
+        return;
+    }
+    drain(session, tokens, NULL, 32);
+    if(lexer_error_count(session) != 3 || lexer_recorded_error_count(session) != 2) {
+        fail("错误数或记录的错误数不对");
+        return;
+    }
+    if(lexer_get_error(session, 0, &error) != LEXER_OK || error.code != 0 || error.offset != 2 || error.length != 1 ||
+       error.line != 1 || error.column != 3) {
+        fail("第一个错误不对");
+    }
+    if(lexer_get_error(session, 1, &error) != LEXER_OK || error.line != 2 || error.column != 1) {
+        fail("第二个错误不对");
+    }
+    if(lexer_get_error(session, 2, &error) != LEXER_INVALID_ARGUMENT) {
+        fail("越界的错误下标应返回LEXER_INVALID_ARGUMENT");
+    }
+    /* 与snprintf相同：截断并以'\0'结尾，返回完整长度 */
+    full = lexer_format_error(session, 0, NULL, 0);
+    if(full <= sizeof buffer || lexer_format_error(session, 0, buffer, sizeof buffer) != full ||
+       strlen(buffer) != sizeof buffer - 1) {
+        fail("lexer_format_error的截断不对");
+    }
+    if(lexer_format_error(session, 5, buffer, sizeof buffer) != 0) {
+        fail("越界的错误下标应返回0");
+    }
+    lexer_set_error_limit(session, 0);
+}
+
+static void checkStatusCodes(lexer_session* session) {
+    static const char source[] = "int x;";
+    lexer_token tokens[8];
+    size_t count = 1;
+    
+    if(lexer_next_tokens(session, NULL, 8, &count) != LEXER_INVALID_ARGUMENT || count != 0) {
+        fail("tokens为NULL时应返回LEXER_INVALID_ARGUMENT");
+    }
+#if SIZE_MAX > UINT32_MAX
+    /* 超过4GiB的长度在扫描之前即被拒绝，不会读到缓冲区之外 */
+    if(lexer_reset(session, source, (size_t)5 << 30) != LEXER_SOURCE_TOO_LARGE) {
+        fail("超过4GiB的源码应返回LEXER_SOURCE_TOO_LARGE");
+    }
+    if(lexer_next_tokens(session, tokens, 8, &count) != LEXER_OK || count != 0) {
+        fail("lexer_reset失败后不应交出Token");
+    }
+#endif
+    /* 之后仍可重新绑定 */
+    if(lexer_reset(session, source, sizeof source - 1) != LEXER_OK || drain(session, tokens, NULL, 8) != 4) {
+        fail("lexer_reset失败后未能重新使用会话");
+    }
+}
+
+int main(void) {
+    lexer_session* session;
+    if(lexer_capi_version() != LEXER_CAPI_VERSION) {
+        fail("lexer_capi_version与头文件不一致");
+    }
+    session = lexer_create(LEXER_ALL_FEATURES);
+    if(!session) {
+        fprintf(stderr, "lexer_create失败\n");
+        return 1;
+    }
+    /* 同一会话依次分析几段源码，也检查了复用 */
+    checkTokens(session);
+    checkErrors(session);
+    checkStatusCodes(session);
+    lexer_destroy(session);
+    if(failures > 0) {
+        fprintf(stderr, "%d 项检查失败\n", failures);
+        return 1;
+    }
+    printf("C接口检查通过\n");
+    return 0;
+}
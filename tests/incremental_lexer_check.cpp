@@ -0,0 +1,155 @@
+// 增量分析检查：对随机源码施加随机编辑（跨越注释的开闭、过长标识符、非法字符与无效UTF-8），
+// 每次编辑后与对同一源码新建的Lexer比较Token、错误和符号表，并核对符号的引用计数。
+// 奇数次编辑后经getTokens/getErrors整体取出，偶数次经getToken/getError逐个取出，
+// 两条路径都覆盖到；编辑位置大多集中在上一次附近，也有随机跳转。参数为随机种子
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "incremental_lexer.h"
+#include "lexer.h"
+
+namespace {
+
+const char* const kFragments[] = {
+    "/*", "*/", "//", "\n", "  ", "\t", "a", "abc", "int ", "x", "while", "123", "99999999999999999999", "+",
+    "=", "&", "|", "@", "&&", "/", "*", "<=", "!", ";", "(", "{", "}", "0",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "\xe4\xb8\xad\xe6\x96\x87", "\xff", "\xe4\xb8",
+};
+constexpr size_t kFragmentCount = sizeof(kFragments) / sizeof(kFragments[0]);
+
+int failures = 0;
+
+std::string randomText(std::mt19937& rng, size_t pieces) {
+    std::string text;
+    for(size_t i = 0; i < pieces; ++i) {
+        text += kFragments[rng() % kFragmentCount];
+    }
+    return text;
+}
+
+bool sameToken(const lexer::Token& a, const lexer::Token& b, std::string_view source) {
+    return a.getType() == b.getType() && a.getOffset() == b.getOffset() && a.getLine() == b.getLine() &&
+           a.getColumn() == b.getColumn() && a.getValue(source) == b.getValue(source);
+}
+
+bool sameError(const lexer::LexicalError& a, const lexer::LexicalError& b, std::string_view source) {
+    return a.getCode() == b.getCode() && a.getOffset() == b.getOffset() && a.getLength() == b.getLength() &&
+           a.getLine() == b.getLine() && a.getColumn() == b.getColumn() &&
+           a.toString(source) == b.toString(source);
+}
+
+// 返回不一致之处的描述，一致时为空
+std::string compare(lexer::IncrementalLexer& incremental, bool whole) {
+    const std::string source(incremental.getSource());
+    lexer::Lexer fresh{std::string_view(source)};
+    const auto& tokens = fresh.tokenize();
+    const auto& errors = fresh.getErrors();
+    
+    std::vector<lexer::Token> gotTokens;
+    std::vector<lexer::LexicalError> gotErrors;
+    if(whole) {
+        gotTokens = incremental.getTokens();
+        gotErrors = incremental.getErrors();
+    } else {
+        for(size_t i = 0; i < incremental.getTokenCount(); ++i) {
+            gotTokens.push_back(incremental.getToken(i));
+        }
+        for(size_t i = 0; i < incremental.getErrorCount(); ++i) {
+            gotErrors.push_back(incremental.getError(i));
+        }
+    }
+    if(gotTokens.size() != tokens.size()) {
+        return "Token数不同";
+    }
+    for(size_t i = 0; i < tokens.size(); ++i) {
+        if(!sameToken(gotTokens[i], tokens[i], source)) {
+            return "第" + std::to_string(i) + "个Token不同";
+        }
+    }
+    if(gotErrors.size() != errors.size()) {
+        return "错误数不同";
+    }
+    for(size_t i = 0; i < errors.size(); ++i) {
+        if(!sameError(gotErrors[i], errors[i], source)) {
+            return "第" + std::to_string(i) + "个错误不同";
+        }
+    }
+    
+    // 符号id须与表中的名字一致，引用计数须等于实际出现次数；存活的名字恰为新分析的符号表
+    const lexer::SymbolTable& symbols = incremental.getSymbolTable();
+    std::vector<size_t> uses(symbols.size(), 0);
+    for(const auto& token : gotTokens) {
+        if(token.getType() != lexer::TokenType::IDENTIFIER) {
+            continue;
+        }
+        const lexer::SymbolInfo* symbol = symbols.lookup(token.getValue(source));
+        if(!symbol || symbol->id != token.getSymbolId()) {
+            return "标识符 " + std::string(token.getValue(source)) + " 的符号id不对";
+        }
+        uses[static_cast<size_t>(symbol->id)]++;
+    }
+    size_t live = 0;
+    for(const auto& symbol : symbols.getAllSymbols()) {
+        if(incremental.getSymbolUses(symbol.id) != uses[static_cast<size_t>(symbol.id)]) {
+            return "符号 " + std::string(symbol.name) + " 的引用计数不对";
+        }
+        live += uses[static_cast<size_t>(symbol.id)] > 0 ? 1 : 0;
+    }
+    if(live != fresh.getSymbolTable().size()) {
+        return "存活的符号数不同";
+    }
+    // 暂留的名字须按时压缩
+    if(symbols.size() > 2 * live + tokens.size() / 8 + 1) {
+        return "暂留的名字过多";
+    }
+    return std::string();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::mt19937 rng(argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 2024u);
+    constexpr int kRounds = 300;
+    constexpr int kEdits = 100;
+    size_t relexed = 0;
+    size_t total = 0;
+    try {
+        for(int round = 0; round < kRounds && failures == 0; ++round) {
+            // 少数几轮用较长的源码，空位和平移跨越较多的Token
+            std::string initial = randomText(rng, round % 10 == 0 ? 3000 : rng() % 200);
+            lexer::IncrementalLexer incremental(initial);
+            std::string problem = compare(incremental, true);
+            size_t previous = 0;
+            for(int edit = 0; edit < kEdits && problem.empty(); ++edit) {
+                size_t size = incremental.getSource().size();
+                size_t offset = rng() % 4 == 0 || previous > size ? rng() % (size + 1)
+                                                                 : std::min(size, previous + rng() % 16);
+                size_t removed = std::min<size_t>(size - offset, rng() % 8);
+                std::string inserted = randomText(rng, rng() % 3);
+                std::string before(incremental.getSource());
+                incremental.applyEdit(offset, removed, inserted);
+                previous = offset + inserted.size();
+                relexed += incremental.getLastRelexedCount();
+                total += incremental.getTokenCount();
+                problem = compare(incremental, edit % 2 == 1);
+                if(!problem.empty()) {
+                    std::cerr << "第" << round << "轮第" << edit << "次编辑后" << problem << "\n"
+                              << "编辑前源码: [" << before << "]\n"
+                              << "offset=" << offset << " removed=" << removed << " inserted=[" << inserted
+                              << "]\n";
+                    failures++;
+                }
+            }
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "异常: " << e.what() << "\n";
+        failures++;
+    }
+    if(failures > 0) {
+        return 1;
+    }
+    std::cout << "增量分析检查通过（重扫 " << relexed << " 个Token，编辑后共 " << total << " 个）\n";
+    return 0;
+}
@@ -0,0 +1,138 @@
+// 并行分析检查：用很小的块对内置源码和 examples/ 下的用例做并行扫描，块边界落在多行注释、
+// 单行注释、长标识符和非法字符附近，把write*输出与串行Lexer的输出逐字节比较。
+// 参数为若干源文件；不带参数时只检查内置的几段源码
+#include <iostream>
+#include <string>
+#include "lexer.h"
+#include "output_writer.h"
+#include "parallel_lexer.h"
+#include "source_file.h"
+
+namespace {
+
+const char* const kBuiltinSources[] = {
+    "",
+    "int x;\n",
+    // 多行注释跨越多块，块首落在注释中间，注释内还有 // 和 /*
+    "int a = 1;\n/* 第一行\n第二行 // 不是单行注释\n/* 仍在注释内\n第四行\n*/ a = a + 1;\nb = a;\n",
+    // 单行注释里的 /* 和 */ 不开闭多行注释，块首紧跟在单行注释之后
+    "x = 1; // 单行注释 /* 不开始多行注释\ny = 2;\n// */ 也不闭合\nz = x + y;\n//\n//\n",
+    // 注释在一行内开闭、紧邻的 */ 与 /*，以及到文件末尾仍未闭合的注释
+    "a/**/b;\n/* 一 */ c /* 二\n*/ d;\n*/ e;\n/*/ f;\n*/\ng /* 未闭合\nh\ni\n",
+    "while(x <= 99999999999999999999) { x--; }\n@ $ \xe4\xb8\xad \xff\n"
+    "abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz = 0;\n\n\n\t\n",
+};
+
+// 与ParallelLexer的默认值不同，块取得很小，线程数也取得较多，使块数不受每线程块数的限制
+const size_t kChunkSizes[] = {1, 2, 5, 16, 64};
+const size_t kThreadCounts[] = {2, 3, 64};
+// 并行拼接时按错误上限截断各块的错误，也要与串行一致
+const size_t kErrorLimits[] = {0, 1, 3};
+
+int failures = 0;
+
+void fail(const std::string& name, const std::string& what) {
+    std::cerr << name << ": " << what << "\n";
+    failures++;
+}
+
+struct Outputs {
+    std::string tokens;
+    std::string symbolRefs;
+    std::string symbols;
+    std::string errors;
+    size_t tokenCount;
+    size_t errorCount;
+};
+
+template <unsigned Features>
+Outputs outputsOf(const lexer::BasicLexer<Features>& lex) {
+    Outputs outputs;
+    {
+        lexer::OutputWriter tokens(outputs.tokens);
+        lex.writeTokens(tokens);
+        lexer::OutputWriter symbolRefs(outputs.symbolRefs);
+        lex.writeTokens(symbolRefs, true);
+        lexer::OutputWriter symbols(outputs.symbols);
+        lex.writeSymbolTable(symbols);
+        lexer::OutputWriter errors(outputs.errors);
+        lex.writeErrors(errors);
+        tokens.close();
+        symbolRefs.close();
+        symbols.close();
+        errors.close();
+    }
+    outputs.tokenCount = lex.getTokenCount();
+    outputs.errorCount = lex.getErrorCount();
+    return outputs;
+}
+
+std::string compare(const Outputs& serial, const Outputs& parallel) {
+    if(parallel.tokens != serial.tokens) {
+        return "Token输出不同";
+    }
+    if(parallel.symbolRefs != serial.symbolRefs) {
+        return "带符号id的Token输出不同";
+    }
+    if(parallel.symbols != serial.symbols) {
+        return "符号表输出不同";
+    }
+    if(parallel.errors != serial.errors) {
+        return "错误输出不同";
+    }
+    if(parallel.tokenCount != serial.tokenCount || parallel.errorCount != serial.errorCount) {
+        return "Token数或错误数不同";
+    }
+    return std::string();
+}
+
+template <unsigned Features>
+void check(const std::string& name, std::string_view source) {
+    for(size_t limit : kErrorLimits) {
+        lexer::BasicLexer<Features> serialLex(source);
+        serialLex.setErrorLimit(limit);
+        serialLex.tokenize();
+        const Outputs serial = outputsOf(serialLex);
+        for(size_t chunkSize : kChunkSizes) {
+            for(size_t threads : kThreadCounts) {
+                lexer::BasicLexer<Features> lex(source);
+                lex.setErrorLimit(limit);
+                lexer::ParallelLexer(threads, chunkSize).tokenize(lex);
+                std::string problem = compare(serial, outputsOf(lex));
+                if(!problem.empty()) {
+                    fail(name, problem + "（块大小 " + std::to_string(chunkSize) + "，线程数 " +
+                                   std::to_string(threads) + "，错误上限 " + std::to_string(limit) + "）");
+                    return;
+                }
+            }
+        }
+    }
+}
+
+void checkBoth(const std::string& name, std::string_view source) {
+    check<lexer::kAllFeatures>(name, source);
+    check<lexer::kAllFeatures & ~lexer::kTrackPositions>(name + "（延迟行列号）", source);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        int index = 0;
+        for(const char* source : kBuiltinSources) {
+            checkBoth("内置源码" + std::to_string(index++), source);
+        }
+        for(int i = 1; i < argc; ++i) {
+            lexer::SourceFile file(argv[i]);
+            checkBoth(argv[i], file.view());
+        }
+    } catch(const std::exception& e) {
+        fail("异常", e.what());
+    }
+    if(failures > 0) {
+        std::cerr << failures << " 项检查失败\n";
+        return 1;
+    }
+    std::cout << "并行分析检查通过\n";
+    return 0;
+}
@@ -0,0 +1,209 @@
+// 结果缓存检查：收入后改写输出文件不影响条目，原地改写命中时链接出去的文件后按未命中处理；
+// 多个线程（各自一个ResultCache，相当于多个进程）同时读写、淘汰同一缓存目录时，
+// 命中的结果总是完整正确的；超过大小上限时淘汰最久未用的条目
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "result_cache.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::atomic<int> failures{0};
+
+void fail(const std::string& name, const std::string& what) {
+    std::cerr << name << ": " << what << "\n";
+    failures++;
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+// 与OutputWriter一样先删除再写，目标可能是命中时链接出来的条目文件
+void writeFile(const fs::path& path, const std::string& content) {
+    std::error_code ec;
+    fs::remove(path, ec);
+    std::ofstream(path, std::ios::binary) << content;
+}
+
+lexer::CacheTargets targetsIn(const fs::path& directory) {
+    fs::create_directories(directory);
+    lexer::CacheTargets targets;
+    targets.tokens = (directory / "tokens.txt").string();
+    targets.symbols = (directory / "symbol_table.txt").string();
+    targets.errors = (directory / "errors.txt").string();
+    return targets;
+}
+
+// 源码i对应的“结果”：内容和计数都由i决定，命中时可以逐字核对
+std::string source(int i) {
+    return "int x" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+}
+
+std::string tokensOf(int i) {
+    return "(1, int)\n(21, x" + std::to_string(i) + ")\n" + std::string(static_cast<size_t>(i) * 37, 't');
+}
+
+void writeResults(const lexer::CacheTargets& targets, int i) {
+    writeFile(targets.tokens, tokensOf(i));
+    writeFile(targets.symbols, "x" + std::to_string(i) + "\n");
+    writeFile(targets.errors, "无错误\n");
+}
+
+bool resultsMatch(const lexer::CacheTargets& targets, const lexer::CachedCounts& counts, int i) {
+    return readFile(targets.tokens) == tokensOf(i) && readFile(targets.symbols) == "x" + std::to_string(i) + "\n" &&
+           readFile(targets.errors) == "无错误\n" && counts.tokens == static_cast<size_t>(i) && counts.symbols == 1;
+}
+
+std::string keyOf(int i) {
+    return lexer::ResultCache::key(source(i), false, 7, 0);
+}
+
+void store(const lexer::ResultCache& cache, const lexer::CacheTargets& targets, int i) {
+    writeResults(targets, i);
+    lexer::CachedCounts counts;
+    counts.tokens = static_cast<size_t>(i);
+    counts.symbols = 1;
+    cache.store(keyOf(i), targets, counts);
+}
+
+void checkDetached(const fs::path& root) {
+    const std::string name = "收入与改写";
+    lexer::ResultCache cache((root / "cache").string(), 1 << 30);
+    lexer::CacheTargets first = targetsIn(root / "out1");
+    store(cache, first, 1);
+    // 收入的是副本：改写原输出文件不影响条目
+    std::ofstream(first.tokens, std::ios::app) << "(99, GARBAGE)\n";
+    
+    lexer::CacheTargets second = targetsIn(root / "out2");
+    lexer::CachedCounts counts;
+    if(!cache.fetch(keyOf(1), second, counts) || !resultsMatch(second, counts, 1)) {
+        fail(name, "改写收入时的输出文件后，命中的结果不对");
+        return;
+    }
+    // 命中时链接出去的文件被原地改写，条目随之改变，之后应按未命中处理
+    std::ofstream(second.tokens, std::ios::app) << "(99, GARBAGE)\n";
+    lexer::CacheTargets third = targetsIn(root / "out3");
+    if(cache.fetch(keyOf(1), third, counts)) {
+        fail(name, "条目被原地改写后仍然命中");
+        return;
+    }
+    store(cache, third, 1);
+    if(!cache.fetch(keyOf(1), targetsIn(root / "out4"), counts) ||
+       !resultsMatch(targetsIn(root / "out4"), counts, 1)) {
+        fail(name, "损坏的条目重新收入后未能命中");
+    }
+}
+
+void checkConcurrent(const fs::path& root) {
+    const std::string name = "并发读写";
+    constexpr int kThreads = 8;
+    constexpr int kRounds = 200;
+    constexpr int kSources = 6;
+    std::vector<std::thread> threads;
+    std::atomic<int> hits{0};
+    for(int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            // 上限很小，淘汰与读写交错进行
+            lexer::ResultCache cache((root / "cache").string(), 2000);
+            lexer::CacheTargets targets = targetsIn(root / ("out" + std::to_string(t)));
+            for(int round = 0; round < kRounds; ++round) {
+                int i = (round * 7 + t) % kSources + 1;
+                lexer::CachedCounts counts;
+                if(cache.fetch(keyOf(i), targets, counts)) {
+                    hits++;
+                    if(!resultsMatch(targets, counts, i)) {
+                        fail(name, "线程" + std::to_string(t) + "命中了不完整或错误的结果");
+                        return;
+                    }
+                } else {
+                    store(cache, targets, i);
+                }
+                if(round % 20 == t) {
+                    std::error_code ec;
+                    fs::remove(root / "cache" / "last-evict", ec);
+                    cache.evict();
+                }
+            }
+        });
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    if(hits == 0) {
+        fail(name, "没有任何一次命中");
+    }
+}
+
+std::uint64_t entryBytes(const fs::path& cacheDir, int i) {
+    std::string key = keyOf(i);
+    fs::path entry = cacheDir / key.substr(0, 2) / key;
+    std::uint64_t bytes = 0;
+    std::error_code ec;
+    for(const auto& file : fs::directory_iterator(entry, ec)) {
+        bytes += file.file_size();
+    }
+    return bytes;
+}
+
+void checkEviction(const fs::path& root) {
+    const std::string name = "淘汰";
+    const fs::path cacheDir = root / "cache";
+    constexpr int kSources = 6;
+    lexer::ResultCache unlimited(cacheDir.string(), 1 << 30);
+    lexer::CacheTargets targets = targetsIn(root / "out");
+    for(int i = 1; i <= kSources; ++i) {
+        store(unlimited, targets, i);
+    }
+    // 源码i的条目最近使用于i分钟之前，源码1最新
+    auto now = fs::file_time_type::clock::now();
+    std::uint64_t newest = 0;
+    for(int i = 1; i <= kSources; ++i) {
+        std::string key = keyOf(i);
+        fs::last_write_time(cacheDir / key.substr(0, 2) / key, now - std::chrono::minutes(i));
+        newest += i <= 2 ? entryBytes(cacheDir, i) : 0;
+    }
+    
+    lexer::ResultCache limited(cacheDir.string(), newest);
+    limited.evict();
+    lexer::CachedCounts counts;
+    for(int i = 1; i <= kSources; ++i) {
+        bool hit = limited.fetch(keyOf(i), targets, counts);
+        if(hit != (i <= 2)) {
+            fail(name, "源码" + std::to_string(i) + (hit ? "的条目应被淘汰" : "的条目不应被淘汰"));
+        }
+    }
+}
+
+}
+
+int main() {
+    fs::path root = fs::temp_directory_path() / ("result_cache_check_" + std::to_string(::getpid()));
+    try {
+        checkDetached(root / "detached");
+        checkConcurrent(root / "concurrent");
+        checkEviction(root / "eviction");
+    } catch(const std::exception& e) {
+        fail("异常", e.what());
+    }
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    if(failures > 0) {
+        std::cerr << failures << " 项检查失败\n";
+        return 1;
+    }
+    std::cout << "结果缓存检查通过\n";
+    return 0;
+}
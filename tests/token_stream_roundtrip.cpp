@@ -0,0 +1,110 @@
+// 二进制Token流往返检查：写出后经TokenStreamReader映射读回，逐项与Lexer的结果比较。
+// 参数为若干源文件；不带参数时只检查内置的几段源码
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "lexer.h"
+#include "source_file.h"
+#include "token_stream.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const kBuiltinSources[] = {
+    "",
+    "int main() { int x = 10; x += 5; return x; }\n",
+    "a = b; b = a; abcdefghijklmnopqrstuvwxyz0123456789 = a;\n/* 未闭合",
+    "x @ y; \xe4\xb8\xad \xff\n while(x <= 99999999999999999999) { x--; }\n",
+};
+
+int failures = 0;
+
+void fail(const std::string& name, const std::string& what) {
+    std::cerr << name << ": " << what << "\n";
+    failures++;
+}
+
+template <unsigned Features>
+void check(const std::string& name, std::string_view source, const fs::path& binaryPath) {
+    lexer::BasicLexer<Features> lex(source);
+    lex.tokenize();
+    lexer::writeTokenStream(lex, binaryPath.string());
+    lexer::TokenStreamReader reader(binaryPath.string());
+    
+    const auto& tokens = lex.getTokens();
+    if(reader.tokenCount() != tokens.size()) {
+        fail(name, "Token数不同");
+        return;
+    }
+    for(size_t i = 0; i < tokens.size(); ++i) {
+        const lexer::Token& token = tokens[i];
+        const lexer::binary::TokenRecord& record = reader.begin()[i];
+        lexer::SourcePosition position = lex.locate(token.getOffset());
+        if(record.code != token.getCategoryCode() || reader.text(record) != token.getValue(source) ||
+           static_cast<int>(record.line) != position.line || static_cast<int>(record.column) != position.column ||
+           reader.symbolId(record) != lex.symbolId(token)) {
+            fail(name, "第" + std::to_string(i) + "个Token不同");
+            return;
+        }
+    }
+    
+    const auto& symbols = lex.getSymbolTable().getAllSymbols();
+    if(reader.symbolCount() != symbols.size()) {
+        fail(name, "符号数不同");
+        return;
+    }
+    for(size_t id = 0; id < symbols.size(); ++id) {
+        if(reader.symbol(id) != symbols[id].name) {
+            fail(name, "符号" + std::to_string(id) + "不同");
+        }
+    }
+    
+    const auto& errors = lex.getErrors();
+    if(reader.errorCount() != errors.size()) {
+        fail(name, "错误数不同");
+        return;
+    }
+    for(size_t i = 0; i < errors.size(); ++i) {
+        const lexer::binary::ErrorRecord& record = reader.error(i);
+        if(reader.message(record) != errors[i].getMessage(source) ||
+           static_cast<int>(record.line) != errors[i].getLine() ||
+           static_cast<int>(record.column) != errors[i].getColumn() ||
+           record.code != static_cast<std::uint32_t>(errors[i].getCode()) || record.offset != errors[i].getOffset() ||
+           record.length != errors[i].getLength()) {
+            fail(name, "第" + std::to_string(i) + "个错误不同");
+        }
+    }
+}
+
+void checkBoth(const std::string& name, std::string_view source, const fs::path& binaryPath) {
+    check<lexer::kAllFeatures>(name, source, binaryPath);
+    check<lexer::kAllFeatures & ~lexer::kTrackPositions>(name + "（延迟行列号）", source, binaryPath);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    fs::path binaryPath = fs::temp_directory_path() / ("token_stream_roundtrip_" + std::to_string(::getpid()) + ".bin");
+    try {
+        int index = 0;
+        for(const char* source : kBuiltinSources) {
+            checkBoth("内置源码" + std::to_string(index++), source, binaryPath);
+        }
+        for(int i = 1; i < argc; ++i) {
+            lexer::SourceFile file(argv[i]);
+            checkBoth(argv[i], file.view(), binaryPath);
+        }
+    } catch(const std::exception& e) {
+        fail("异常", e.what());
+    }
+    std::error_code ec;
+    fs::remove(binaryPath, ec);
+    if(failures > 0) {
+        std::cerr << failures << " 项检查失败\n";
+        return 1;
+    }
+    std::cout << "二进制Token流往返检查通过\n";
+    return 0;
+}